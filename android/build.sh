@@ -17,8 +17,11 @@ cp assets/icon_mdpi.png $BUILD/res/drawable-mdpi/icon.png
 cp assets/icon_hdpi.png $BUILD/res/drawable-hdpi/icon.png
 cp assets/icon_xhdpi.png $BUILD/res/drawable-xhdpi/icon.png
 
-# Copy other assets
-cp assets/* android/build/assets
+# Stage the assets that ship in the APK. The WAVs and PNGs are only
+# sources for the QOA music and textures.pak that build.sh makes from them
+rm -rf $BUILD/assets
+mkdir -p $BUILD/assets
+(cd assets && tar cf - --exclude='*.wav' --exclude='*.png' .) | (cd $BUILD/assets && tar xf -)
 
 # ______________________________________________________________________________
 #
@@ -89,7 +92,7 @@ $BUILD_TOOLS/dx --verbose --dex --output=$BUILD/dex/classes.dex $BUILD/obj
 
 # Add resources and assets to APK
 $BUILD_TOOLS/aapt package -f \
-	-M $BUILD/AndroidManifest.xml -S $BUILD/res -A assets \
+	-M $BUILD/AndroidManifest.xml -S $BUILD/res -A $BUILD/assets \
 	-I $SDK/platforms/android-$API_VERSION/android.jar -F $NAME.apk $BUILD/dex
 
 # Add libraries to APK
@@ -8,6 +8,7 @@ uniform float itime;
 uniform float darkness;
 uniform int jekyll;      // use int for GLES bool
 uniform vec2 cam_scroll;
+uniform sampler2D lightmap;  // light accumulation target, same layout as texture0
 
 // Constants
 const vec2 scroll  = vec2(0.05, -0.05);
@@ -64,6 +65,9 @@ void foreground(inout vec4 col) {
     vec4 tex_color = texture2D(texture0, fragTexCoord);
     col = tex_color;
 
+    // Torches and flashes light the scene before the fog and darkness
+    col.rgb += texture2D(lightmap, fragTexCoord).rgb;
+
     // Larger scale = smoother shapes
     vec2 uv = fragTexCoord * 2.5 + cam_scroll * 0.001;
 
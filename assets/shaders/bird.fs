@@ -0,0 +1,16 @@
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+varying vec2 segCoord;
+varying float segLen;
+varying float segRadius;
+varying vec4 fragColor;
+
+void main() {
+    // Capsule around the segment: lines get round caps, zero-length
+    // segments are circles
+    float dx = segCoord.x - clamp(segCoord.x, 0.0, segLen);
+    if (dx * dx + segCoord.y * segCoord.y > segRadius * segRadius) discard;
+    gl_FragColor = fragColor;
+}
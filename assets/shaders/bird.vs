@@ -0,0 +1,71 @@
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+// One bird is six capsule segments (two triangles each). The mesh only
+// says which segment, which end and which side a corner is; where the
+// segment goes comes from the instance.
+attribute vec4 vertexPosition;   // x: segment 0-5, y: end 0/1, z: side -1/1
+attribute vec4 instanceBody;     // xy: position, zw: unit heading
+attribute vec4 instanceState;    // x: flap timer, y: 0 idle 1 flying 2 departing, z: facing
+
+uniform mat4 mvp;
+
+varying vec2 segCoord;           // along and across the segment, in pixels
+varying float segLen;
+varying float segRadius;
+varying vec4 fragColor;
+
+const vec4 DARKGRAY = vec4(80.0, 80.0, 80.0, 255.0) / 255.0;
+const vec4 GRAY     = vec4(130.0, 130.0, 130.0, 255.0) / 255.0;
+const vec4 GOLD     = vec4(255.0, 203.0, 0.0, 255.0) / 255.0;
+const vec4 BLACK    = vec4(0.0, 0.0, 0.0, 1.0);
+
+void main() {
+    float seg = vertexPosition.x;
+    vec2 p = instanceBody.xy;
+    vec2 a = p;
+    vec2 b = p;
+    float r = 0.0;
+    vec4 col = BLACK;
+
+    if (instanceState.y < 0.5) {
+        // Standing bird, pecking for 0.4s of every 3s
+        float facing = instanceState.z;
+        vec2 head = p + vec2(facing * 3.0, -4.0);
+        if (mod(instanceState.x, 3.0) < 0.4) head += vec2(facing, 2.0);
+
+        if (seg < 0.5)      { b = p + vec2(-1.0, 4.0); r = 0.5; }
+        else if (seg < 1.5) { b = p + vec2(1.0, 4.0); r = 0.5; }
+        else if (seg < 2.5) { r = 3.0; col = DARKGRAY; }
+        else if (seg < 3.5) { a = head; b = head; r = 1.8; col = DARKGRAY; }
+        else if (seg < 4.5) { a = head; b = head + vec2(facing * 2.0, 0.0); r = 0.5; col = GOLD; }
+    } else {
+        // Flying bird: wings sweep back as they fold
+        vec2 dir = instanceBody.zw;
+        vec2 perp = vec2(-dir.y, dir.x);
+        float flapSpeed = instanceState.y > 1.5 ? 22.0 : 16.0;
+        float flap = sin(instanceState.x * flapSpeed);
+        float perpSpan = 4.5 + flap * 2.5;
+        float dirSweep = -2.5 + flap * 1.5;
+        vec2 head = p + dir * 4.0;
+
+        if (seg < 0.5)      { b = p + perp * perpSpan + dir * dirSweep; r = 0.75; col = DARKGRAY; }
+        else if (seg < 1.5) { b = p + dir * dirSweep - perp * perpSpan; r = 0.75; col = DARKGRAY; }
+        else if (seg < 2.5) { a = p - dir * 4.0; b = head; r = 1.0; col = GRAY; }
+        else if (seg < 3.5) { a = head; b = head + dir * 1.5; r = 0.5; col = GOLD; }
+    }
+
+    vec2 axis = b - a;
+    float len = length(axis);
+    vec2 u = len > 0.0001 ? axis / len : vec2(1.0, 0.0);
+    vec2 n = vec2(-u.y, u.x);
+    float along = vertexPosition.y > 0.5 ? len + r : -r;
+    float across = vertexPosition.z * r;
+
+    segCoord = vec2(along, across);
+    segLen = len;
+    segRadius = r;
+    fragColor = col;
+    gl_Position = mvp * vec4(a + u * along + n * across, 0.0, 1.0);
+}
@@ -0,0 +1,52 @@
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+varying vec2 fragTexCoord;
+
+uniform vec4 lightRect;      // world rect of the quad covering the light
+uniform vec2 lightPos;       // world position
+uniform float lightRadius;
+uniform vec2 lightDir;       // facing, cone lights only
+uniform float lightCosHalf;  // cos of half the cone angle, -1 for point lights
+uniform vec4 lightColor;     // alpha scales the intensity
+
+uniform sampler2D wallMask;  // one texel per tile, white = wall
+uniform vec4 wallMaskRect;   // world rect covered by the mask
+
+const float TILE = 16.0;
+const int SHADOW_STEPS = 24;
+
+float wallAt(vec2 world) {
+    vec2 uv = (world - wallMaskRect.xy) / wallMaskRect.zw;
+    if (uv.x < 0.0 || uv.y < 0.0 || uv.x > 1.0 || uv.y > 1.0) return 0.0;
+    return texture2D(wallMask, uv).r;
+}
+
+void main() {
+    vec2 world = lightRect.xy + fragTexCoord * lightRect.zw;
+    vec2 toFrag = world - lightPos;
+    float dist = length(toFrag);
+    if (dist >= lightRadius) discard;
+
+    float cone = 1.0;
+    if (lightCosHalf > -1.0) {
+        float c = dot(toFrag / max(dist, 0.001), lightDir);
+        cone = smoothstep(lightCosHalf, lightCosHalf + 0.03, c);
+        if (cone <= 0.0) discard;
+    }
+
+    // March back to the light through the wall mask. The tile under the
+    // fragment is skipped so wall faces still catch the light.
+    vec2 fragTile = floor(world / TILE);
+    vec2 lightTile = floor(lightPos / TILE);
+    for (int i = 1; i < SHADOW_STEPS; i++) {
+        vec2 p = mix(world, lightPos, float(i) / float(SHADOW_STEPS));
+        vec2 tile = floor(p / TILE);
+        if (tile == fragTile || tile == lightTile) continue;
+        if (wallAt(p) > 0.5) discard;
+    }
+
+    float falloff = 1.0 - dist / lightRadius;
+    gl_FragColor = vec4(lightColor.rgb * lightColor.a * falloff * cone, 1.0);
+}
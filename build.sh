@@ -26,6 +26,18 @@ fi
 # Run the setup if the project hasn't been set up yet
 [[ -e lib/$TARGET ]] || ./setup.sh
 
+# Pack the textures into assets/textures.pak, raw pixels the game uploads
+# without decoding. The packer runs on this machine, so it is built with the
+# host compiler even when cross compiling.
+${HOST_CC:-cc} tools/pack.c -Iraylib/src -O2 -lm -o tools/pack
+tools/pack assets assets/textures.pak
+
+# Music ships as QOA, which src/music.c decodes on its own thread
+${HOST_CC:-cc} tools/music.c -Iraylib/src -O2 -lm -o tools/music
+for wav in assets/music/*.wav; do
+	tools/music "$wav" "${wav%.wav}.qoa"
+done
+
 # Build options for each target
 case "$TARGET" in
 	"Windows_NT")
@@ -35,7 +47,7 @@ case "$TARGET" in
 		CC="$ARCH-w64-mingw32-gcc"
 		EXT=".exe"
 		PLATFORM="PLATFORM_DESKTOP"
-		TARGET_FLAGS="-lopengl32 -lgdi32 -lwinmm -static -Wl,--subsystem,windows -fsanitize=address -g -O0"
+		TARGET_FLAGS="-lopengl32 -lgdi32 -lwinmm -lpthread -static -Wl,--subsystem,windows -fsanitize=address -g -O0"
 		;;
 
 	"Linux")
@@ -56,7 +68,8 @@ case "$TARGET" in
 		EXT=".html"
 		PLATFORM="PLATFORM_WEB"
 		TARGET_FLAGS="-s ASYNCIFY -s USE_GLFW=3 -s TOTAL_MEMORY=67108864 \
-		-s FORCE_FILESYSTEM=1 --shell-file src/shell.html --preload-file assets"
+		-s FORCE_FILESYSTEM=1 --shell-file src/shell.html --preload-file assets \
+		--exclude-file *.png --exclude-file *.wav"
 		source emsdk/emsdk_env.sh
 		;;
 
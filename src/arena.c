@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "arena.h"
+
+#define ARENA_ALIGN 16
+
+struct arenaBlock{
+  struct arenaBlock *next;
+  size_t cap;
+  size_t used;
+  // payload follows, ARENA_ALIGN aligned
+};
+
+struct arena{
+  struct arenaBlock *blocks; // current block first
+  size_t blockSize;
+};
+
+static size_t alignUp(size_t n){
+  return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+#define BLOCK_HEADER alignUp(sizeof(struct arenaBlock))
+
+static struct arenaBlock *newBlock(size_t cap){
+  struct arenaBlock *b = malloc(BLOCK_HEADER + cap);
+  assert(b != NULL);
+  b->next = NULL;
+  b->cap  = cap;
+  b->used = 0;
+  return b;
+}
+
+arena arenaCreate(size_t blockSize){
+  arena a = malloc(sizeof(struct arena));
+  assert(a != NULL);
+  a->blockSize = alignUp(blockSize);
+  a->blocks = newBlock(a->blockSize);
+  return a;
+}
+
+void *arenaAlloc(arena a, size_t size){
+  size = alignUp(size ? size : 1);
+  struct arenaBlock *b = a->blocks;
+
+  if (b->used + size > b->cap){
+    if (size > a->blockSize / 4){
+      // big one-off allocation: give it its own block behind the current
+      // one so the rest of the current block is not wasted
+      struct arenaBlock *big = newBlock(size);
+      big->used = size;
+      big->next = b->next;
+      b->next = big;
+      return (char *)big + BLOCK_HEADER;
+    }
+    b = newBlock(a->blockSize);
+    b->next = a->blocks;
+    a->blocks = b;
+  }
+
+  void *p = (char *)b + BLOCK_HEADER + b->used;
+  b->used += size;
+  return p;
+}
+
+void *arenaCalloc(arena a, size_t count, size_t size){
+  void *p = arenaAlloc(a, count * size);
+  memset(p, 0, count * size);
+  return p;
+}
+
+// Keep the first block (the most recent one) and drop the rest
+void arenaReset(arena a){
+  struct arenaBlock *b = a->blocks->next;
+  while (b != NULL){
+    struct arenaBlock *next = b->next;
+    free(b);
+    b = next;
+  }
+  a->blocks->next = NULL;
+  a->blocks->used = 0;
+}
+
+void arenaFree(arena a){
+  struct arenaBlock *b = a->blocks;
+  while (b != NULL){
+    struct arenaBlock *next = b->next;
+    free(b);
+    b = next;
+  }
+  free(a);
+}
+
+void arenaAbsorb(arena dst, arena src){
+  struct arenaBlock *last = src->blocks;
+  while (last->next != NULL) last = last->next;
+  // behind dst's current block, which keeps taking new allocations
+  last->next = dst->blocks->next;
+  dst->blocks->next = src->blocks;
+  free(src);
+}
+
+void arenaOwned(void *el){
+  (void) el;
+}
@@ -0,0 +1,24 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator for data that lives and dies together, e.g. everything
+// generated for one level. Allocations are never freed one by one;
+// arenaFree releases the whole lot in one go.
+typedef struct arena *arena;
+
+extern arena arenaCreate(size_t blockSize);
+extern void *arenaAlloc(arena a, size_t size);
+extern void *arenaCalloc(arena a, size_t count, size_t size);
+extern void arenaReset(arena a);
+extern void arenaFree(arena a);
+// Hand every block of src over to dst and destroy src. Lets worker
+// threads fill private arenas that end up owned by one level.
+extern void arenaAbsorb(arena dst, arena src);
+
+// Free function for dynarrays/hashes whose elements live in an arena:
+// the container is torn down normally, the elements go with the arena.
+extern void arenaOwned(void *el);
+
+#endif
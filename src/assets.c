@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "raylib.h"
+#include "assets.h"
+#include "pack.h"
+
+#if !defined(PLATFORM_WEB)
+#include <pthread.h>
+#define ASSETS_THREADED
+#endif
+
+#if defined(PLATFORM_ANDROID)
+  #define ASSETS_ROOT ""            // the APK's assets are the working directory
+#else
+  #define ASSETS_ROOT "assets/"
+#endif
+
+#define ASSETS_MAX 256
+#define ASSETS_DECODERS 2
+
+typedef enum { ASSET_QUEUED, ASSET_DECODING, ASSET_DECODED, ASSET_UPLOADED } assetState;
+
+typedef struct assetJob{
+  char path[96];
+  Texture2D *dst;
+  Image image;
+  bool borrowed;      // image points into the pack
+  assetState state;
+} assetJob;
+
+struct assetLoader{
+  assetPack pack;
+  assetJob jobs[ASSETS_MAX];
+  int count;
+  int nextDecode;     // jobs before it have been picked up by a decoder
+  int uploaded;
+
+#ifdef ASSETS_THREADED
+  bool quit;
+  pthread_t threads[ASSETS_DECODERS];
+  int threadCount;
+  pthread_mutex_t lock;
+  pthread_cond_t work;
+  pthread_cond_t decoded;
+#endif
+};
+
+#ifdef ASSETS_THREADED
+
+static void *decoderMain(void *arg){
+  assetLoader a = arg;
+  pthread_mutex_lock(&a->lock);
+  for (;;){
+    while (!a->quit && a->nextDecode >= a->count)
+      pthread_cond_wait(&a->work, &a->lock);
+    if (a->quit) break;
+
+    assetJob *job = &a->jobs[a->nextDecode++];
+    if (job->state != ASSET_QUEUED) continue;
+    job->state = ASSET_DECODING;
+    pthread_mutex_unlock(&a->lock);
+
+    Image image = LoadImage(job->path);
+
+    pthread_mutex_lock(&a->lock);
+    job->image = image;
+    job->state = ASSET_DECODED;
+    pthread_cond_broadcast(&a->decoded);
+  }
+  pthread_mutex_unlock(&a->lock);
+  return NULL;
+}
+
+#define LOCK(a) pthread_mutex_lock(&(a)->lock)
+#define UNLOCK(a) pthread_mutex_unlock(&(a)->lock)
+
+#else
+
+#define LOCK(a) ((void) (a))
+#define UNLOCK(a) ((void) (a))
+
+#endif
+
+assetLoader assetsCreate(void){
+  assetLoader a = calloc(1, sizeof(struct assetLoader));
+  assert(a != NULL);
+  a->pack = packOpen(assetsPath("textures.pak"));
+  if (a->pack == NULL) TraceLog(LOG_INFO, "ASSETS: no texture pack, decoding PNGs");
+#ifdef ASSETS_THREADED
+  pthread_mutex_init(&a->lock, NULL);
+  pthread_cond_init(&a->work, NULL);
+  pthread_cond_init(&a->decoded, NULL);
+  for (int i = 0; i < ASSETS_DECODERS; i++){
+    if (pthread_create(&a->threads[i], NULL, &decoderMain, a) != 0) break;
+    a->threadCount++;
+  }
+#endif
+  return a;
+}
+
+void assetsFree(assetLoader a){
+#ifdef ASSETS_THREADED
+  LOCK(a);
+  a->quit = true;
+  pthread_cond_broadcast(&a->work);
+  UNLOCK(a);
+  for (int i = 0; i < a->threadCount; i++)
+    pthread_join(a->threads[i], NULL);
+  pthread_cond_destroy(&a->decoded);
+  pthread_cond_destroy(&a->work);
+  pthread_mutex_destroy(&a->lock);
+#endif
+  for (int i = 0; i < a->count; i++){
+    if (a->jobs[i].state == ASSET_DECODED && !a->jobs[i].borrowed) UnloadImage(a->jobs[i].image);
+  }
+  packClose(a->pack);
+  free(a);
+}
+
+void assetsTexture(assetLoader a, const char *path, Texture2D *dst){
+  *dst = (Texture2D){0};
+  LOCK(a);
+  assert(a->count < ASSETS_MAX);
+  assetJob *job = &a->jobs[a->count];
+  snprintf(job->path, sizeof(job->path), "%s%s", ASSETS_ROOT, path);
+  job->dst = dst;
+  // Packed pixels need no decoding, only the upload
+  job->borrowed = packImage(a->pack, path, &job->image);
+  job->state = job->borrowed ? ASSET_DECODED : ASSET_QUEUED;
+  a->count++;
+#ifdef ASSETS_THREADED
+  pthread_cond_signal(&a->work);
+#endif
+  UNLOCK(a);
+}
+
+Animation assetsAnimation(assetLoader a, const char *path, int numberOfFrames){
+  Animation animation = malloc(sizeof(struct Animation));
+  assert(animation != NULL);
+  animation->frames = assetsTextures(a, path, numberOfFrames);
+  animation->numberOfFrames = numberOfFrames;
+  return animation;
+}
+
+Texture2D *assetsTextures(assetLoader a, const char *path, int numberOfTexs){
+  Texture2D *texs = malloc(sizeof(Texture2D) * numberOfTexs);
+  assert(texs != NULL);
+  char buffer[96];
+  for (int i = 1; i < numberOfTexs + 1; i++){
+    snprintf(buffer, sizeof(buffer), "%s%d.png", path, i);
+    assetsTexture(a, buffer, &texs[i-1]);
+  }
+  return texs;
+}
+
+Texture2D assetsTextureNow(assetLoader a, const char *path){
+  Image image;
+  if (packImage(a->pack, path, &image)) return LoadTextureFromImage(image);
+  return LoadTexture(assetsPath(path));
+}
+
+int assetsQueued(assetLoader a){
+  return a->count;
+}
+
+// Uploads one decoded texture among the first `count`, false if none is
+// decoded yet. Called with the lock held, which it drops for the upload.
+static bool uploadOne(assetLoader a, int count){
+  for (int i = 0; i < count; i++){
+    assetJob *job = &a->jobs[i];
+#ifndef ASSETS_THREADED
+    // no decoders, so the next image is decoded right here
+    if (job->state == ASSET_QUEUED){
+      job->image = LoadImage(job->path);
+      job->state = ASSET_DECODED;
+      a->nextDecode = i + 1;
+    }
+#endif
+    if (job->state != ASSET_DECODED) continue;
+    Image image = job->image;
+    UNLOCK(a);
+    *job->dst = LoadTextureFromImage(image);
+    if (!job->borrowed) UnloadImage(image);
+    LOCK(a);
+    job->state = ASSET_UPLOADED;
+    a->uploaded++;
+    return true;
+  }
+  return false;
+}
+
+bool assetsUpload(assetLoader a, double seconds){
+  double end = GetTime() + seconds;
+  LOCK(a);
+  while (a->uploaded < a->count && uploadOne(a, a->count) && GetTime() < end)
+    ;
+  bool done = a->uploaded == a->count;
+  UNLOCK(a);
+  return done;
+}
+
+void assetsFinish(assetLoader a, int count){
+  LOCK(a);
+  for (;;){
+    bool pending = false;
+    for (int i = 0; i < count && !pending; i++)
+      pending = a->jobs[i].state != ASSET_UPLOADED;
+    if (!pending) break;
+    if (uploadOne(a, count)) continue;
+#ifdef ASSETS_THREADED
+    pthread_cond_wait(&a->decoded, &a->lock);
+#endif
+  }
+  UNLOCK(a);
+}
+
+float assetsProgress(assetLoader a){
+  LOCK(a);
+  float progress = a->count > 0 ? (float)a->uploaded / a->count : 1.0f;
+  UNLOCK(a);
+  return progress;
+}
+
+const char *assetsPath(const char *path){
+  static char buffer[128];
+  snprintf(buffer, sizeof(buffer), "%s%s", ASSETS_ROOT, path);
+  return buffer;
+}
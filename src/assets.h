@@ -0,0 +1,43 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <stdbool.h>
+
+#include "raylib.h"
+#include "utils.h"
+
+// Loads textures in the background: images are decoded on worker threads
+// as soon as they are queued, and the main thread uploads the decoded ones
+// to the GPU a few at a time between frames. Images found in textures.pak
+// skip the decode and are uploaded straight from the pack. Queued textures
+// stay zeroed until uploaded. Paths are relative to the assets directory
+// and never go through ChangeDirectory, which would race the workers. Web
+// builds have no threads and decode during assetsUpload instead.
+typedef struct assetLoader *assetLoader;
+
+extern assetLoader assetsCreate(void);
+// Joins the workers and drops images that were never uploaded.
+extern void assetsFree(assetLoader a);
+
+extern void assetsTexture(assetLoader a, const char *path, Texture2D *dst);
+// Frames are path1.png .. pathN.png.
+extern Animation assetsAnimation(assetLoader a, const char *path, int numberOfFrames);
+extern Texture2D *assetsTextures(assetLoader a, const char *path, int numberOfTexs);
+// Loads one texture right away, for what has to be on screen before
+// anything else.
+extern Texture2D assetsTextureNow(assetLoader a, const char *path);
+
+// How many textures have been queued so far, to wait for a prefix of them.
+extern int assetsQueued(assetLoader a);
+// Uploads decoded textures until `seconds` have passed; true once every
+// queued texture is on the GPU.
+extern bool assetsUpload(assetLoader a, double seconds);
+// Blocks until the first `count` queued textures are on the GPU.
+extern void assetsFinish(assetLoader a, int count);
+extern float assetsProgress(assetLoader a);
+
+// Path of a file under the assets directory, for loaders other than
+// textures (music, shaders). Valid until the next call.
+extern const char *assetsPath(const char *path);
+
+#endif
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "birddraw.h"
+
+#define BIRD_SEGMENTS 6
+#define BIRD_VERTICES (BIRD_SEGMENTS * 6)
+
+typedef struct birdDraw{
+  bool available;
+  Shader shader;
+  int mvpLoc;
+  unsigned int vao;
+  unsigned int meshVbo;
+  unsigned int instanceVbo;
+  int instanceCap;
+  int instanceBodyLoc, instanceStateLoc;
+  birdInstance *staged;
+  int stagedCap;
+} birdDraw;
+
+static birdDraw s_birds = {0};
+
+// Point the per-instance attributes at the instance buffer; done again
+// whenever the buffer is reallocated
+static void bindInstanceAttributes(void){
+  rlEnableVertexBuffer(s_birds.instanceVbo);
+  rlSetVertexAttribute(s_birds.instanceBodyLoc, 4, RL_FLOAT, false, sizeof(birdInstance), 0);
+  rlEnableVertexAttribute(s_birds.instanceBodyLoc);
+  rlSetVertexAttributeDivisor(s_birds.instanceBodyLoc, 1);
+  rlSetVertexAttribute(s_birds.instanceStateLoc, 4, RL_FLOAT, false, sizeof(birdInstance), 4 * sizeof(float));
+  rlEnableVertexAttribute(s_birds.instanceStateLoc);
+  rlSetVertexAttributeDivisor(s_birds.instanceStateLoc, 1);
+}
+
+void birdDrawInit(void){
+  // GLES2 only has instancing through extensions rlgl does not report
+  int gl = rlGetVersion();
+  if (gl != RL_OPENGL_33 && gl != RL_OPENGL_43 && gl != RL_OPENGL_ES_30) return;
+
+  s_birds.shader = LoadShader("shaders/bird.vs", "shaders/bird.fs");
+  if (s_birds.shader.id == rlGetShaderIdDefault()){
+    TraceLog(LOG_WARNING, "Bird shaders unavailable, birds are drawn one by one");
+    return;
+  }
+  s_birds.mvpLoc = GetShaderLocation(s_birds.shader, "mvp");
+  int meshLoc = GetShaderLocationAttrib(s_birds.shader, "vertexPosition");
+  s_birds.instanceBodyLoc = GetShaderLocationAttrib(s_birds.shader, "instanceBody");
+  s_birds.instanceStateLoc = GetShaderLocationAttrib(s_birds.shader, "instanceState");
+  if (meshLoc < 0 || s_birds.instanceBodyLoc < 0 || s_birds.instanceStateLoc < 0){
+    UnloadShader(s_birds.shader);
+    return;
+  }
+
+  // Two triangles per segment: (end, side) corners of the capsule's box
+  static const float corner[6][2] = { {0, -1}, {1, -1}, {1, 1}, {0, -1}, {1, 1}, {0, 1} };
+  float mesh[BIRD_VERTICES * 4];
+  for (int s = 0; s < BIRD_SEGMENTS; s++){
+    for (int c = 0; c < 6; c++){
+      float *v = &mesh[(s * 6 + c) * 4];
+      v[0] = (float)s;
+      v[1] = corner[c][0];
+      v[2] = corner[c][1];
+      v[3] = 0.0f;
+    }
+  }
+
+  s_birds.vao = rlLoadVertexArray();
+  rlEnableVertexArray(s_birds.vao);
+  s_birds.meshVbo = rlLoadVertexBuffer(mesh, sizeof(mesh), false);
+  rlSetVertexAttribute(meshLoc, 4, RL_FLOAT, false, 0, 0);
+  rlEnableVertexAttribute(meshLoc);
+  s_birds.instanceCap = 256;
+  s_birds.instanceVbo = rlLoadVertexBuffer(NULL, s_birds.instanceCap * sizeof(birdInstance), true);
+  bindInstanceAttributes();
+  rlDisableVertexArray();
+
+  s_birds.available = true;
+}
+
+void birdDrawUnload(void){
+  if (s_birds.available){
+    rlUnloadVertexArray(s_birds.vao);
+    rlUnloadVertexBuffer(s_birds.meshVbo);
+    rlUnloadVertexBuffer(s_birds.instanceVbo);
+    UnloadShader(s_birds.shader);
+  }
+  free(s_birds.staged);
+  memset(&s_birds, 0, sizeof(s_birds));
+}
+
+bool birdDrawAvailable(void){
+  return s_birds.available;
+}
+
+birdInstance *birdDrawReserve(int count){
+  if (count > s_birds.stagedCap){
+    s_birds.stagedCap = count;
+    s_birds.staged = realloc(s_birds.staged, count * sizeof(birdInstance));
+    assert(s_birds.staged != NULL);
+  }
+  return s_birds.staged;
+}
+
+void birdDrawInstances(int count){
+  if (!s_birds.available || count <= 0) return;
+
+  // Whatever is batched so far has to land underneath the birds
+  rlDrawRenderBatchActive();
+
+  rlEnableVertexArray(s_birds.vao);
+  if (count > s_birds.instanceCap){
+    while (s_birds.instanceCap < count) s_birds.instanceCap *= 2;
+    rlUnloadVertexBuffer(s_birds.instanceVbo);
+    s_birds.instanceVbo = rlLoadVertexBuffer(NULL, s_birds.instanceCap * sizeof(birdInstance), true);
+    bindInstanceAttributes();
+  }
+  rlUpdateVertexBuffer(s_birds.instanceVbo, s_birds.staged, count * sizeof(birdInstance), 0);
+
+  rlEnableShader(s_birds.shader.id);
+  Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+  rlSetUniformMatrix(s_birds.mvpLoc, mvp);
+  rlDrawVertexArrayInstanced(0, BIRD_VERTICES, count);
+  rlDisableShader();
+  rlDisableVertexArray();
+}
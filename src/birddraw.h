@@ -0,0 +1,31 @@
+#ifndef BIRDDRAW_H
+#define BIRDDRAW_H
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+// Birds drawn in one instanced draw call: the shape, flapping and pecking
+// are worked out in shaders/bird.vs from a few floats per bird.
+typedef struct birdInstance{
+  Vector2 pos;
+  Vector2 dir;          // unit heading, flying birds only
+  float flapTimer;
+  float state;          // 0 idle, 1 flying, 2 departing
+  float facing;         // 1 or -1, idle birds only
+  float unused;
+} birdInstance;
+
+// Loads the bird shaders, so call it from inside the assets directory.
+extern void birdDrawInit(void);
+extern void birdDrawUnload(void);
+// False when the GL version has no instancing or the shaders did not
+// compile; the caller then draws the birds itself.
+extern bool birdDrawAvailable(void);
+// Staging space for `count` instances, valid until the next call.
+extern birdInstance *birdDrawReserve(int count);
+// Draws the first `count` staged instances with the current camera; call
+// between BeginMode2D and EndMode2D.
+extern void birdDrawInstances(int count);
+
+#endif
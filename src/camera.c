@@ -4,6 +4,7 @@
 #include "physics.h"
 #include "map.h"
 #include "camera.h"
+#include "utils.h"
 
 void UpdateCameraRoom(Camera2D *camera, entity player) {
     // Which room is player in?
@@ -17,7 +18,7 @@ void UpdateCameraRoom(Camera2D *camera, entity player) {
     };
 
     // Smoothly move camera target toward room center
-    float lerpSpeed = 5.0f * GetFrameTime();
+    float lerpSpeed = 5.0f * gameFrameTime();
     camera->target.x = Lerp(camera->target.x, target.x, lerpSpeed);
     camera->target.y = Lerp(camera->target.y, target.y, lerpSpeed);
 
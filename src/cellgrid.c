@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+
+#include "cellgrid.h"
+
+cellGrid cellGridCreate(float cellSize){
+  cellGrid g = calloc(1, sizeof(struct cellGrid));
+  assert(g != NULL);
+  g->cellSize = cellSize;
+  return g;
+}
+
+void cellGridFree(cellGrid g){
+  if (!g) return;
+  free(g->start);
+  free(g->items);
+  free(g->slotX);
+  free(g->slotY);
+  free(g->bucketOf);
+  free(g);
+}
+
+int cellGridCellOf(cellGrid g, float v){
+  return (int)floorf(v / g->cellSize);
+}
+
+int cellGridBucket(cellGrid g, int cx, int cy){
+  unsigned h = (unsigned)cx * 73856093u ^ (unsigned)cy * 19349663u;
+  return (int)(h & (unsigned)(g->buckets - 1));
+}
+
+void cellGridBuild(cellGrid g, const Vector2 *pos, int n){
+  g->count = n;
+  if (n > g->itemCap){
+    g->itemCap = n;
+    g->items = realloc(g->items, n * sizeof(int));
+    g->slotX = realloc(g->slotX, n * sizeof(int));
+    g->slotY = realloc(g->slotY, n * sizeof(int));
+    g->bucketOf = realloc(g->bucketOf, n * sizeof(int));
+    assert(g->items && g->slotX && g->slotY && g->bucketOf);
+  }
+
+  g->buckets = 16;
+  while (g->buckets < 2 * n) g->buckets <<= 1;
+  if (g->buckets + 1 > g->startCap){
+    g->startCap = g->buckets + 1;
+    g->start = realloc(g->start, g->startCap * sizeof(int));
+    assert(g->start != NULL);
+  }
+  memset(g->start, 0, (g->buckets + 1) * sizeof(int));
+
+  // count
+  for (int i = 0; i < n; i++){
+    int b = cellGridBucket(g, cellGridCellOf(g, pos[i].x), cellGridCellOf(g, pos[i].y));
+    g->bucketOf[i] = b;
+    g->start[b + 1]++;
+  }
+  // prefix sum: start[b] is now where bucket b begins
+  for (int b = 0; b < g->buckets; b++) g->start[b + 1] += g->start[b];
+  // scatter, using start[b] as the cursor; it ends up where bucket b ends
+  for (int i = 0; i < n; i++){
+    int slot = g->start[g->bucketOf[i]]++;
+    g->items[slot] = i;
+    g->slotX[slot] = cellGridCellOf(g, pos[i].x);
+    g->slotY[slot] = cellGridCellOf(g, pos[i].y);
+  }
+  // every cursor sits on the next bucket's start, so shift them back one
+  memmove(g->start + 1, g->start, g->buckets * sizeof(int));
+  g->start[0] = 0;
+}
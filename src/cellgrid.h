@@ -0,0 +1,30 @@
+#ifndef CELLGRID_H
+#define CELLGRID_H
+
+#include "raylib.h"
+
+// Points bucketed by square cell with a counting sort, rebuilt from scratch
+// whenever the points move. Cells are hashed into a power-of-two table of
+// about twice as many buckets as points, so memory follows the point count
+// however far the points spread. Bucket b holds slots start[b] .. start[b+1],
+// contiguous runs in cell order; a slot's own cell is stored next to it so
+// scans can skip points from other cells that share the bucket.
+struct cellGrid{
+  float cellSize;
+  int buckets;            // power of two
+  int *start;             // buckets + 1 running offsets into the slots
+  int *items;             // point index of each slot
+  int *slotX, *slotY;     // cell of each slot
+  int *bucketOf;          // scratch: bucket of each point
+  int count;
+  int startCap, itemCap;
+};
+typedef struct cellGrid *cellGrid;
+
+extern cellGrid cellGridCreate(float cellSize);
+extern void cellGridFree(cellGrid g);
+extern void cellGridBuild(cellGrid g, const Vector2 *pos, int n);
+extern int cellGridBucket(cellGrid g, int cx, int cy);
+extern int cellGridCellOf(cellGrid g, float v);
+
+#endif
@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <math.h>
 
 #include "raylib.h"
 #include "raymath.h"
@@ -11,6 +13,8 @@
 #include "enemy.h"
 #include "utils.h"
 #include "projectile.h"
+#include "lighting.h"
+#include "sfx.h"
 
 #define MOVE_STRAIGHT_COST 10
 #define MOVE_DIAGONAL_COST 14
@@ -43,17 +47,11 @@ void pathNodeFree(DA_ELEMENT el){
     free(p);
 }
 
-void enemyFree(DA_ELEMENT el) {
-    Enemy enemy = (Enemy) el;
-    if (!enemy) return;
+static void enemyRelease(Enemy enemy) {
     if (enemy->path) {
         free_dynarray(enemy->path); // Only free the container
         enemy->path = NULL;
     }
-    if (enemy->e) {
-        free(enemy->e);
-    }
-    free(enemy);
 }
 
 static dynarray calculatePath(pathNode endNode){
@@ -77,7 +75,7 @@ static dynarray calculatePath(pathNode endNode){
 }
 
 
-static dynarray getNeighbourList(pathNode currentNode, hash map){
+static dynarray getNeighbourList(pathNode currentNode, tilemap map){
     dynarray neighbourList = create_dynarray(NULL, NULL);
     int offset[8][2] = {
         { 1,  0}, { 0, -1}, {-1,  0}, { 0,  1}, // Cardinal
@@ -203,7 +201,7 @@ static void resetNode(pathNode node) {
 
 // }
 
-static dynarray pathFinding(Vector2 playerPos, Vector2 enemyPos, hash map) {
+static dynarray pathFinding(Vector2 playerPos, Vector2 enemyPos, tilemap map) {
     int pcx = ((int) playerPos.x) / TILE_SIZE;
     int pcy = ((int) playerPos.y) / TILE_SIZE;
     int ecx = ((int) enemyPos.x) / TILE_SIZE;
@@ -298,48 +296,30 @@ static dynarray pathFinding(Vector2 playerPos, Vector2 enemyPos, hash map) {
 
 
 void updateAngle(Enemy e, Vector2 vel){
-    e->angle = atan2f(vel.y , vel.x);
+    e->hot->angle = atan2f(vel.y , vel.x);
 }
 
-bool HasLOS(Vector2 from, Vector2 to, hash map) {
-    Vector2 dir = Vector2Normalize(Vector2Subtract(to, from));
-    Vector2 step = Vector2Scale(dir, 4.0f); 
-    Vector2 ray = from;
-    float maxDist = Vector2Distance(from, to);
-
-    struct rect rects[MAX_RECTS];
-    int rectCount = rectsAround(map, from, rects);
-    // dynarray rects = rectsAround(map, from);
-
-    float distTravelled = 0;
-    bool blocked = false;
-
-    while (distTravelled < maxDist) {
-        if (CheckCollisionPointRec(ray, (Rectangle){to.x-2, to.y-2, 4, 4})) {
-            // hit player region
-            // free_dynarray(rects);
-            return true;
-        }
-
-        for (int i = 0; i < rectCount; i++) {
-            rect r = &rects[i];
-            if (CheckCollisionPointRec(ray, r->rectange)) {
-                blocked = true;
-                break;
-            }
-        }
-        if (blocked) break;
+bool HasLOS(Vector2 from, Vector2 to, tilemap map) {
+    return mapLineOfSight(map, from, to);
+}
 
-        ray = Vector2Add(ray, step);
-        distTravelled += Vector2Length(step);
-    }
 
-    // free_dynarray(rects);
-    return false;
+static void enemyCastFov(Enemy e, tilemap map){
+    e->fovX = (int)floorf(e->e->pos.x / TILE_SIZE);
+    e->fovY = (int)floorf(e->e->pos.y / TILE_SIZE);
+    mapFieldOfView(map, e->fovX, e->fovY, ENEMY_FOV_RADIUS, e->fovVisible, e->fovOpaque);
+    e->fovValid = true;
 }
 
+static bool enemyFovSees(Enemy e, Vector2 pos){
+    if (!e->fovValid) return false;
+    int x = (int)floorf(pos.x / TILE_SIZE) - e->fovX + ENEMY_FOV_RADIUS;
+    int y = (int)floorf(pos.y / TILE_SIZE) - e->fovY + ENEMY_FOV_RADIUS;
+    if (x < 0 || y < 0 || x >= ENEMY_FOV_SIZE || y >= ENEMY_FOV_SIZE) return false;
+    return (e->fovVisible[y] >> x) & 1u;
+}
 
-bool PlayerInTorchCone(Enemy enemy, entity player, float torchRadius, float torchFOV, hash map) {
+bool PlayerInTorchCone(Enemy enemy, entity player, float torchRadius, float torchFOV) {
     Vector2 toPlayer = Vector2Subtract(player->pos, enemy->e->pos);
     float dist = Vector2Length(toPlayer);
 
@@ -348,15 +328,15 @@ bool PlayerInTorchCone(Enemy enemy, entity player, float torchRadius, float torc
 
     // Angle check
     Vector2 dirToPlayer = Vector2Normalize(toPlayer);
-    Vector2 facing = (Vector2){ cosf(enemy->angle), sinf(enemy->angle) };
+    Vector2 facing = (Vector2){ cosf(enemy->hot->angle), sinf(enemy->hot->angle) };
 
     float dot = Vector2DotProduct(facing, dirToPlayer);
     float angleToPlayer = acosf(dot);
 
     if (angleToPlayer > torchFOV * 0.5f) return false;
 
-    // LOS check (optional but recommended)
-    if (!HasLOS(enemy->e->pos, player->pos, map)) return false;
+    // LOS check against the cached field of view
+    if (!enemyFovSees(enemy, player->pos)) return false;
 
     return true;
 }
@@ -365,13 +345,13 @@ bool PlayerInTorchCone(Enemy enemy, entity player, float torchRadius, float torc
 static inline void updateAngleSmooth(Enemy e, Vector2 vel, float turnSpeed) {
     if (fabsf(vel.x) < 0.01f && fabsf(vel.y) < 0.01f) return;
     float targetAngle = atan2f(vel.y, vel.x);
-    float delta = targetAngle - e->angle;
+    float delta = targetAngle - e->hot->angle;
     if (delta > PI) delta -= 2*PI;
     if (delta < -PI) delta += 2*PI;
-    e->angle += delta * turnSpeed * GetFrameTime();
+    e->hot->angle += delta * turnSpeed * gameFrameTime();
 }
 
-#define torchRadius 150
+#define torchRadius LIGHTING_TORCH_RADIUS
 #define torchFOV (60 * (PI/180)) // 60-degree cone
 
 static inline void worldCenterOfNode(pathNode n, Rectangle entRect, Vector2 *out) {
@@ -379,8 +359,18 @@ static inline void worldCenterOfNode(pathNode n, Rectangle entRect, Vector2 *out
     out->y = n->y * TILE_SIZE + TILE_SIZE/2.0f - entRect.height / 2.0f;
 }
 
-Vector2 computeVelOfEnemy(Enemy enemy, entity player, hash map, dynarray projectiles, bool isHacking) {
-    const float dt = GetFrameTime();
+void enemySense(Enemy enemy, entity player, tilemap map, bool isHacking) {
+    enemyCastFov(enemy, map);
+    enemy->hot->playerVisible = PlayerInTorchCone(enemy, player, torchRadius, torchFOV);
+    if (enemy->hot->playerVisible) enemy->lastKnownPlayerPos = player->pos;
+
+    // Only enemies that can be ACTIVE get to shoot
+    bool mayBeActive = enemy->hot->state == ACTIVE || enemy->hot->playerVisible || isHacking;
+    enemy->hot->lineOfFire = mayBeActive && HasLOS(enemy->e->pos, player->pos, map);
+}
+
+Vector2 computeVelOfEnemy(Enemy enemy, entity player, tilemap map, dynarray projectiles, bool isHacking) {
+    const float dt = gameFrameTime();
 
     // --- Animation ---
     enemy->animTimer += dt;
@@ -391,40 +381,37 @@ Vector2 computeVelOfEnemy(Enemy enemy, entity player, hash map, dynarray project
 
     Vector2 vel = (Vector2){0,0};
 
-    // --- Throttle sensing (vision/LOS) ---
-    enemy->senseCooldown -= dt;
-    if (enemy->senseCooldown <= 0.0f) {
-        float baseSensePeriod = 0.10f;
-        enemy->senseCooldown = baseSensePeriod + (enemy->staggerSlot * 0.01f);
-        enemy->playerVisible = PlayerInTorchCone(enemy, player, torchRadius, torchFOV, map);
-        if (enemy->playerVisible) enemy->lastKnownPlayerPos = player->pos;
-    }
-
     // --- State update (cheap) ---
     // float distToLastKnown = Vector2Distance(enemy->e->pos, enemy->lastKnownPlayerPos);
-    // if (enemy->playerVisible)       enemy->state = ACTIVE;
-    // else if (distToLastKnown > torchRadius * 1.5f) enemy->state = IDLE;
+    // if (enemy->hot->playerVisible)       enemy->hot->state = ACTIVE;
+    // else if (distToLastKnown > torchRadius * 1.5f) enemy->hot->state = IDLE;
 
     // --- State update (cheap) ---
     float distToLastKnown = Vector2Distance(enemy->e->pos, enemy->lastKnownPlayerPos);
 
     if (isHacking) {
         // Force enemy into ACTIVE and lock it there while hacking
-        enemy->state = ACTIVE;
+        enemy->hot->state = ACTIVE;
         enemy->lastKnownPlayerPos = player->pos;
-        // enemy->playerVisible = true;  // treat as if player is always "seen"
+        // enemy->hot->playerVisible = true;  // treat as if player is always "seen"
     } else {
-        if (enemy->playerVisible)       
-            enemy->state = ACTIVE;
+        if (enemy->hot->playerVisible)       
+            enemy->hot->state = ACTIVE;
         else if (distToLastKnown > torchRadius * 2.5f) 
-            enemy->state = IDLE;
+            enemy->hot->state = IDLE;
     }
 
     // --- ACTIVE: follow player path ---
-    if (enemy->state == ACTIVE) {
+    if (enemy->hot->state == ACTIVE) {
         int goalX = (int)(player->pos.x) / TILE_SIZE;
         int goalY = (int)(player->pos.y) / TILE_SIZE;
 
+        // a path holds path nodes, which go away with their chunk
+        if (enemy->path && enemy->pathEpoch != mapEpoch(map)) {
+            free_dynarray(enemy->path);
+            enemy->path = NULL;
+        }
+
         bool needRecompute = false;
         if (!enemy->path || enemy->currentStep >= (enemy->path->len)) needRecompute = true;
         if (goalX != enemy->lastGoalTileX || goalY != enemy->lastGoalTileY) needRecompute = true;
@@ -432,13 +419,14 @@ Vector2 computeVelOfEnemy(Enemy enemy, entity player, hash map, dynarray project
         enemy->repathCooldown -= dt;
 
         // TraceLog(LOG_INFO, "Enemy ACTIVE: distToLastKnown=%.1f, playerVisible=%d, needRecompute=%d, repathCooldown=%.2f",
-                //  distToLastKnown, enemy->playerVisible, needRecompute, enemy->repathCooldown);
+                //  distToLastKnown, enemy->hot->playerVisible, needRecompute, enemy->repathCooldown);
 
         
         if (needRecompute && enemy->repathCooldown <= 0.0f) {
             if (enemy->path) { free_dynarray(enemy->path); enemy->path = NULL; }
             double startTime = GetTime();
             enemy->path = pathFinding(player->pos, enemy->e->pos, map);
+            enemy->pathEpoch = mapEpoch(map);
             double endTime = GetTime();
             TraceLog(LOG_INFO, "Pathfinding took %.3f ms, path len=%d", (endTime - startTime)*1000.0, enemy->path ? enemy->path->len : 0);
             enemy->lastGoalTileX = goalX;
@@ -468,17 +456,19 @@ Vector2 computeVelOfEnemy(Enemy enemy, entity player, hash map, dynarray project
 
         enemy->shootTimer = fmaxf(0.0f, enemy->shootTimer - dt);
 
-        if (HasLOS(enemy->e->pos, player->pos, map) && enemy->shootTimer <= 0.0f){
+        bool clearShot = enemy->hot->lineOfFire && enemy->hot->senseAge <= ENEMY_LINE_OF_FIRE_MAX_AGE;
+        if (clearShot && enemy->shootTimer <= 0.0f){
             // Shoot 
             Vector2 toPlayer = Vector2Subtract(player->pos, enemy->e->pos);
             projectileShoot(projectiles, enemy->e->pos, Vector2Normalize(toPlayer), 4, PISTOL);
+            sfxPlayAt(SFX_ENEMY_SHOT, enemy->e->pos, player->pos);
             enemy->shootTimer = enemy->shootCooldown;
         }
 
     }
 
     // --- IDLE: wander ---
-    if (enemy->state == IDLE) {
+    if (enemy->hot->state == IDLE) {
         if (enemy->idleTimer <= 0) {
             if (enemy->movingIdle) {
                 enemy->movingIdle = false;
@@ -536,25 +526,83 @@ Vector2 computeVelOfEnemy(Enemy enemy, entity player, hash map, dynarray project
 
 
 
-Enemy enemyCreate(int startX, int startY, int width, int height){
-    Enemy enemy = malloc(sizeof(struct Enemy));
-    assert(enemy != NULL);
-    enemy->e = entityCreate(startX, startY, width, height);
+enemySpawn enemySpawnRoll(rng *r, float x, float y){
+    enemySpawn spawn;
+    spawn.pos = (Vector2){ x, y };
+    spawn.staggerSlot = rngRange(r, 0, 2); // spread work across ~3 frames
+    spawn.shootCooldown = rngRange(r, 40, 60) / 60.0f;
+    spawn.health = 100;
+    return spawn;
+}
+
+struct enemyStore{
+    float clock;                // seconds of game time, for sensing
+    int count, cap;             // slots handed out, and there are
+    enemyHot *hot;
+    struct Enemy *cold;
+    int roomsW, roomsH;
+    int *roomStart;             // room r owns roomSlots[roomStart[r] .. roomStart[r + 1])
+    int *roomLen;               // of which the first roomLen[r] are live
+    enemyHandle *roomSlots;
+};
+
+enemyStore enemyStoreCreate(arena a, int roomsW, int roomsH, const int *roomCounts){
+    int rooms = roomsW * roomsH;
+    enemyStore s = arenaAlloc(a, sizeof(struct enemyStore));
+    s->roomsW = roomsW;
+    s->roomsH = roomsH;
+    s->roomStart = arenaAlloc(a, (rooms + 1) * sizeof(int));
+    s->roomLen = arenaAlloc(a, rooms * sizeof(int));
+    s->roomStart[0] = 0;
+    for (int r = 0; r < rooms; r++){
+        s->roomStart[r + 1] = s->roomStart[r] + roomCounts[r];
+        s->roomLen[r] = 0;
+    }
+    s->clock = 0.0f;
+    s->count = 0;
+    s->cap = s->roomStart[rooms];
+    int slots = s->cap > 0 ? s->cap : 1;
+    s->hot = arenaAlloc(a, slots * sizeof(enemyHot));
+    s->cold = arenaAlloc(a, slots * sizeof(struct Enemy));
+    s->roomSlots = arenaAlloc(a, slots * sizeof(enemyHandle));
+    return s;
+}
+
+enemyHandle enemyStoreAdd(enemyStore s, int roomX, int roomY, enemySpawn spawn){
+    int room = roomY * s->roomsW + roomX;
+    assert(s->count < s->cap);
+    assert(s->roomStart[room] + s->roomLen[room] < s->roomStart[room + 1]);
+    int slot = s->count++;
+    enemyHandle h = (enemyHandle)slot + 1;
+    s->roomSlots[s->roomStart[room] + s->roomLen[room]++] = h;
+
+    enemyHot *hot = &s->hot[slot];
+    hot->body = (struct entity){ spawn.pos, (Rectangle){ spawn.pos.x, spawn.pos.y, ENEMY_SIZE, ENEMY_SIZE } };
+    hot->angle = 0;
+    hot->state = IDLE;
+    hot->sensedAt = -1000.0f;          // never, so sensed first
+    hot->senseAge = 1000.0f;
+    hot->playerVisible = false;
+    hot->lineOfFire = false;
+    hot->alive = true;
+
+    Enemy enemy = &s->cold[slot];
+    enemy->e = &hot->body;
+    enemy->hot = hot;
+    enemy->room = room;
     enemy->path = NULL;
-    enemy->state = IDLE;
+    enemy->pathEpoch = 0;
     enemy->idleTimer = 0;
-    enemy->angle = 0;
 
     enemy->repathCooldown  = 0.0f;
     enemy->repathInterval  = 0.25f;        // solve at most ~4x/sec (tweak)
     enemy->lastGoalTileX   = INT_MIN;
     enemy->lastGoalTileY   = INT_MIN;
-    enemy->senseCooldown   = 0.0f;         // throttle vision checks
-    enemy->playerVisible   = false;
-    enemy->lastKnownPlayerPos = enemy->e->pos;
-    enemy->staggerSlot     = GetRandomValue(0, 2); // spread work across ~3 frames
+    enemy->lastKnownPlayerPos = spawn.pos;
+    enemy->fovValid = false;
+    enemy->staggerSlot     = spawn.staggerSlot;
 
-    enemy->health = 100; 
+    enemy->health = spawn.health; 
     enemy->maxHealth = 100;
 
     enemy->currentFrame = 0;
@@ -563,63 +611,147 @@ Enemy enemyCreate(int startX, int startY, int width, int height){
     enemy->running = 0; 
 
     // enemy->projectiles = create_dynarray(&projectileFree, NULL);
-    enemy->shootCooldown = GetRandomValue(40, 60) / 60.0f; 
+    enemy->shootCooldown = spawn.shootCooldown; 
     enemy->shootTimer = 0.0f; 
 
-    return enemy;
+    return h;
 }
 
+void enemyStoreRelease(enemyStore s){
+    for (int i = 0; i < s->count; i++)
+        enemyRelease(&s->cold[i]);
+}
 
-void enemyDrawTorch(Enemy e, hash map, int rays, Color col) {
-    Vector2 origin = e->e->pos;
-
-    struct rect rects[MAX_RECTS];
-    int rectCount = rectsAround(map, origin, rects);
-    // dynarray rects = rectsAround(map, origin);
-
-    float angleStep = torchFOV / rays;
-    float rayDistances[rays + 1];
-
-    for (int i = 0; i <= rays; i++) {
-        float a = e->angle - torchFOV / 2 + angleStep * i;
-        Vector2 dir = { cosf(a), sinf(a) };
-        Vector2 ray = origin;
-        float traveled = 0;
-        bool blocked = false;
-
-        while (traveled < torchRadius) {
-            for (int j = 0; j < rectCount; j++) {
-                rect r = &rects[j];
-                if (CheckCollisionPointRec(ray, r->rectange)) {
-                    blocked = true;
-                    break;
-                }
-            }
-            if (blocked) break;
+Enemy enemyGet(enemyStore s, enemyHandle h){
+    if (h == 0 || h > (enemyHandle)s->count || !s->hot[h - 1].alive) return NULL;
+    return &s->cold[h - 1];
+}
 
-            ray = Vector2Add(ray, Vector2Scale(dir, 4.0f));
-            traveled += 4.0f;
+int enemySenseSchedule(enemyStore s, const enemyHandle *room, int count,
+                       entity player, bool isHacking, enemyHandle *out){
+    s->clock += gameFrameTime();
+
+    // the most urgent ENEMY_SENSE_BUDGET so far, by falling priority
+    float best[ENEMY_SENSE_BUDGET];
+    int n = 0;
+    for (int i = 0; i < count; i++){
+        int slot = room[i] - 1;
+        enemyHot *hot = &s->hot[slot];
+        float age = s->clock - hot->sensedAt;
+        hot->senseAge = age;
+
+        bool urgent = hot->state == ACTIVE || hot->playerVisible || isHacking;
+        float period = urgent ? ENEMY_SENSE_PERIOD_ACTIVE : ENEMY_SENSE_PERIOD_IDLE;
+        if (age < period) continue;
+
+        // periods overdue, weighted up to 3x for enemies near the player
+        float dist = Vector2Distance(hot->body.pos, player->pos);
+        float priority = (age + s->cold[slot].staggerSlot * 0.01f) / period
+                       * (1.0f + 2.0f * torchRadius / (dist + torchRadius));
+
+        int k;
+        if (n < ENEMY_SENSE_BUDGET) k = n++;
+        else if (priority > best[ENEMY_SENSE_BUDGET - 1]) k = ENEMY_SENSE_BUDGET - 1;
+        else continue;
+        while (k > 0 && best[k - 1] < priority){
+            best[k] = best[k - 1];
+            out[k] = out[k - 1];
+            k--;
         }
+        best[k] = priority;
+        out[k] = room[i];
+    }
+
+    for (int i = 0; i < n; i++){
+        enemyHot *hot = &s->hot[out[i] - 1];
+        hot->sensedAt = s->clock;
+        hot->senseAge = 0.0f;
+    }
+    return n;
+}
 
-        rayDistances[i] = traveled;
+int enemyRoom(enemyStore s, int roomX, int roomY, const enemyHandle **out){
+    *out = NULL;
+    if (roomX < 0 || roomY < 0 || roomX >= s->roomsW || roomY >= s->roomsH) return 0;
+    int room = roomY * s->roomsW + roomX;
+    *out = &s->roomSlots[s->roomStart[room]];
+    return s->roomLen[room];
+}
+
+void enemyKill(enemyStore s, enemyHandle h){
+    Enemy enemy = enemyGet(s, h);
+    if (!enemy) return;
+    enemy->hot->alive = false;
+    enemyRelease(enemy);
+
+    // keep the room in spawn order, the update order depends on it
+    enemyHandle *list = &s->roomSlots[s->roomStart[enemy->room]];
+    int len = s->roomLen[enemy->room];
+    for (int i = 0; i < len; i++){
+        if (list[i] != h) continue;
+        memmove(&list[i], &list[i + 1], (len - i - 1) * sizeof(enemyHandle));
+        s->roomLen[enemy->room]--;
+        break;
     }
+}
+
 
-    // free_dynarray(rects);
+// Distance from origin along angle a to the first wall of the cached
+// field of view, walking its tiles by grid DDA; torchRadius if none.
+static float torchReach(Enemy e, Vector2 origin, float a){
+    float dx = cosf(a), dy = sinf(a);
+    int x = (int)floorf(origin.x / TILE_SIZE);
+    int y = (int)floorf(origin.y / TILE_SIZE);
+    int stepX = dx > 0 ? 1 : -1;
+    int stepY = dy > 0 ? 1 : -1;
+    float tMaxX = dx > 0 ? ((x + 1) * TILE_SIZE - origin.x) / dx
+                : dx < 0 ? (x * TILE_SIZE - origin.x) / dx : INFINITY;
+    float tMaxY = dy > 0 ? ((y + 1) * TILE_SIZE - origin.y) / dy
+                : dy < 0 ? (y * TILE_SIZE - origin.y) / dy : INFINITY;
+    float tDeltaX = dx != 0 ? fabsf(TILE_SIZE / dx) : INFINITY;
+    float tDeltaY = dy != 0 ? fabsf(TILE_SIZE / dy) : INFINITY;
+
+    for (;;) {
+        float t;
+        if (tMaxX < tMaxY) {
+            x += stepX;
+            t = tMaxX;
+            tMaxX += tDeltaX;
+        } else {
+            y += stepY;
+            t = tMaxY;
+            tMaxY += tDeltaY;
+        }
+        if (t >= torchRadius) return torchRadius;
 
-    // Draw a filled torch cone using DrawCircleSector approximation
-    for (int i = 0; i < rays; i++) {
-        float startAngle = (e->angle - torchFOV/2 + angleStep * i) * RAD2DEG;
-        float endAngle   = (e->angle - torchFOV/2 + angleStep * (i+1)) * RAD2DEG;
-        float radius     = MIN(rayDistances[i], rayDistances[i+1]);
+        int lx = x - e->fovX + ENEMY_FOV_RADIUS;
+        int ly = y - e->fovY + ENEMY_FOV_RADIUS;
+        if (lx < 0 || ly < 0 || lx >= ENEMY_FOV_SIZE || ly >= ENEMY_FOV_SIZE) return torchRadius;
+        if ((e->fovOpaque[ly] >> lx) & 1u) return t;
+    }
+}
 
-        DrawCircleSector(origin, radius, startAngle, endAngle, 1, col);
+// The cone is one triangle fan over the walls of the cached field of view
+void enemyDrawTorch(Enemy e, Color col) {
+    if (!e->fovValid) return;
+    Vector2 origin = e->e->pos;
+    float angleStep = torchFOV / ENEMY_TORCH_RAYS;
+
+    // raylib fans wind counter-clockwise on screen, i.e. by falling angle
+    Vector2 fan[ENEMY_TORCH_RAYS + 2];
+    fan[0] = origin;
+    for (int i = 0; i <= ENEMY_TORCH_RAYS; i++) {
+        float a = e->hot->angle + torchFOV / 2 - angleStep * i;
+        float reach = torchReach(e, origin, a);
+        fan[i + 1] = (Vector2){ origin.x + cosf(a) * reach, origin.y + sinf(a) * reach };
     }
+    DrawTriangleFan(fan, ENEMY_TORCH_RAYS + 2, col);
 }
 
 
 
 
-void enemyDraw(Enemy e, entity player, hash map, Animation *enemyAnimations, Texture2D gunTex){
+void enemyDraw(Enemy e, entity player, Animation *enemyAnimations, Texture2D gunTex){
     // Draw enemy
     // DrawRectangleRec(e->e->rect, RED);
     Texture2D frame = enemyAnimations[e->running]->frames[e->currentFrame];
@@ -646,7 +778,7 @@ void enemyDraw(Enemy e, entity player, hash map, Animation *enemyAnimations, Tex
     if (e->facingRight != 1){
         aimAngle = aimAngle + 180.0f;
     }
-    if (e->state == ACTIVE){
+    if (e->hot->state == ACTIVE){
         DrawTexturePro(gunTex, gunSrc, gunDst, gunOrigin, aimAngle, WHITE);
     }
     else{
@@ -657,10 +789,15 @@ void enemyDraw(Enemy e, entity player, hash map, Animation *enemyAnimations, Tex
     // DrawTexture(frame, e->e->rect.x, e->e->rect.y, WHITE);
 
 
-    // Torch effect
-    BeginBlendMode(BLEND_ADDITIVE);
-    enemyDrawTorch(e, map, 10, ColorAlpha(WHITE, 0.2f));
-    EndBlendMode();
+    // Torch effect: a shadowed cone in the light pass, or the fan over the
+    // cached field of view when the light shader is unavailable
+    if (lightingEnabled()) {
+        lightingAddCone(e->e->pos, e->hot->angle, torchFOV, torchRadius, ColorAlpha(WHITE, 0.35f));
+    } else {
+        BeginBlendMode(BLEND_ADDITIVE);
+        enemyDrawTorch(e, ColorAlpha(WHITE, 0.2f));
+        EndBlendMode();
+    }
 
     // --- Health bar ---
     float barWidth = e->e->rect.width;
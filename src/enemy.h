@@ -5,6 +5,7 @@
 #include "map.h"
 #include "physics.h"
 #include "utils.h"
+#include "rng.h"
 
 // Enemy states
 // Idle -> circling around the spawn point 
@@ -16,27 +17,57 @@ typedef enum {
     ACTIVE,
 } State;
 
+// Torch field of view, cast once per sense tick (see enemyCastFov) and
+// shared by sensing and drawing the torch cone
+#define ENEMY_FOV_RADIUS 10     // tiles, covers the torch radius from anywhere in a tile
+#define ENEMY_FOV_SIZE (2 * ENEMY_FOV_RADIUS + 1)
+#define ENEMY_TORCH_RAYS 16
+
+#define ENEMY_SIZE 15           // side of the collision box
+
+// Sensing is scheduled centrally, see enemySenseSchedule
+#define ENEMY_SENSE_BUDGET 8                // full sensing queries per frame
+#define ENEMY_SENSE_PERIOD_IDLE 0.10f       // soonest an enemy is sensed again
+#define ENEMY_SENSE_PERIOD_ACTIVE 0.05f
+#define ENEMY_LINE_OF_FIRE_MAX_AGE 0.25f    // older than this, hold fire
+
+// Fields every enemy in the room touches every frame. They live packed
+// together in the enemy store, apart from the rest of the enemy, so the
+// sensing, movement and broadphase loops stream through them.
+typedef struct enemyHot{
+    struct entity body;         // the enemy's e points here
+    float angle;
+    State state;
+    float sensedAt;             // store clock when the results below were taken
+    float senseAge;             // and how old they are this frame
+    bool  playerVisible;        // cached result of PlayerInTorchCone
+    bool  lineOfFire;           // clear shot at the player, see enemySense
+    bool  alive;
+} enemyHot;
+
 struct Enemy{
+    entity e; 
+    enemyHot *hot;
     dynarray path;
+    unsigned pathEpoch;         // mapEpoch the path was solved under
     int targetTileX;
     int targetTileY;
     int currentStep;
-    entity e; 
-    State state;
     Vector2 idleTarget; 
     float idleTimer; 
     bool movingIdle;
-    float angle; 
 
     // enemy.h (add to struct Enemy)
     float repathCooldown;       // time left until we’re allowed to repath
     float repathInterval;       // base interval between path solves (sec)
     int   lastGoalTileX;        // last player tile we solved towards
     int   lastGoalTileY;
-    float senseCooldown;        // throttle LOS/cone checks
-    bool  playerVisible;        // cached result of PlayerInTorchCone
     Vector2 lastKnownPlayerPos; // where we last saw the player
-    int   staggerSlot;          // 0..(N-1) to distribute work across frames
+    int   staggerSlot;          // 0..2, breaks sensing ties between enemies
+    int   fovX, fovY;           // tile the field of view was cast from
+    bool  fovValid;
+    uint32_t fovVisible[ENEMY_FOV_SIZE];
+    uint32_t fovOpaque[ENEMY_FOV_SIZE];
 
     int health;
     int maxHealth; 
@@ -51,13 +82,50 @@ struct Enemy{
     float shootCooldown; 
     float shootTimer; 
 
+    int room;                   // index of the room list it is in
 };
 typedef struct Enemy *Enemy;  
 
-extern Vector2 computeVelOfEnemy(Enemy enemy, entity player, hash map, dynarray projectiles, bool isHacking);
-extern Enemy enemyCreate(int startX, int startY, int width, int height);
+// Where and how an enemy starts. Rolled while the level is generated so
+// the level stream is drawn in the same order however enemies are stored.
+typedef struct enemySpawn{
+    Vector2 pos;
+    int staggerSlot;
+    float shootCooldown;
+    int health;
+} enemySpawn;
+
+// All enemies of a level, in two arrays indexed by slot: hot fields and
+// the rest. Each room keeps the handles spawned in it in one contiguous
+// list. Slots are never reused within a level, so a handle stays valid
+// (and resolves to NULL once its enemy is killed) until the store goes.
+typedef uint32_t enemyHandle;   // slot + 1, 0 is no enemy
+typedef struct enemyStore *enemyStore;
+
+extern enemySpawn enemySpawnRoll(rng *r, float x, float y);
+// roomCounts[ry * roomsW + rx] is how many enemies will be added to each
+// room; everything is allocated from the arena up front.
+extern enemyStore enemyStoreCreate(arena a, int roomsW, int roomsH, const int *roomCounts);
+extern enemyHandle enemyStoreAdd(enemyStore s, int roomX, int roomY, enemySpawn spawn);
+// Drops the paths the enemies own; the rest goes with the arena.
+extern void enemyStoreRelease(enemyStore s);
+extern Enemy enemyGet(enemyStore s, enemyHandle h);
+// Live enemies spawned in room (roomX, roomY), in spawn order.
+extern int enemyRoom(enemyStore s, int roomX, int roomY, const enemyHandle **out);
+extern void enemyKill(enemyStore s, enemyHandle h);
+
+// Picks which of a room's enemies sense this frame: those whose cached
+// results have outlived their period, oldest and closest to the player
+// first, at most ENEMY_SENSE_BUDGET of them. Stamps them as sensed, ages
+// the rest, and advances the store clock, so call it once per frame.
+extern int enemySenseSchedule(enemyStore s, const enemyHandle *room, int count,
+                              entity player, bool isHacking, enemyHandle *out);
+// Sensing half of the enemy update: vision and line of fire, cached on
+// the enemy for computeVelOfEnemy. Only reads the map and player and only
+// writes this enemy, so the scheduled enemies can sense in parallel.
+extern void enemySense(Enemy enemy, entity player, tilemap map, bool isHacking);
+extern Vector2 computeVelOfEnemy(Enemy enemy, entity player, tilemap map, dynarray projectiles, bool isHacking);
 extern void updateAngle(Enemy e, Vector2 vel);
-extern void enemyDraw(Enemy e, entity player, hash map, Animation *enemyAnimations, Texture2D gunTex);
-extern void enemyFree(DA_ELEMENT el);
+extern void enemyDraw(Enemy e, entity player, Animation *enemyAnimations, Texture2D gunTex);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+  #define FLOCK_SSE2
+#elif defined(__ARM_NEON)
+  #include <arm_neon.h>
+  #define FLOCK_NEON
+#endif
+
+#include "flock.h"
+
+#define SEPARATION_MIN_D2 (0.001f * 0.001f)
+
+void flockReserve(flockBirds *b, int n){
+  if (n <= b->cap) return;
+  b->cap = n;
+  b->px = realloc(b->px, n * sizeof(float));
+  b->py = realloc(b->py, n * sizeof(float));
+  b->vx = realloc(b->vx, n * sizeof(float));
+  b->vy = realloc(b->vy, n * sizeof(float));
+  assert(b->px && b->py && b->vx && b->vy);
+}
+
+void flockRelease(flockBirds *b){
+  free(b->px);
+  free(b->py);
+  free(b->vx);
+  free(b->vy);
+  *b = (flockBirds){0};
+}
+
+// One bird at a time, used for the tail of every run and on targets
+// without a vector unit
+static void accumulateScalar(const flockBirds *b, int z, int end, int cx, int cy,
+                             int self, flockSums *s){
+  float sx = b->px[self], sy = b->py[self];
+  for (; z < end; z++){
+    if (z == self || b->cellX[z] != cx || b->cellY[z] != cy) continue;
+    s->count++;
+    s->velX += b->vx[z];
+    s->velY += b->vy[z];
+    s->posX += b->px[z];
+    s->posY += b->py[z];
+    float dx = sx - b->px[z], dy = sy - b->py[z];
+    float d2 = dx * dx + dy * dy;
+    if (d2 > SEPARATION_MIN_D2){
+      s->sepX += dx / d2;
+      s->sepY += dy / d2;
+    }
+  }
+}
+
+#if defined(FLOCK_SSE2)
+
+static inline float hsum(__m128 v){
+  __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(v, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+void flockAccumulate(const flockBirds *b, int begin, int end, int cx, int cy,
+                     int self, flockSums *s){
+  int z = begin;
+  if (end - begin >= 4){
+    const __m128 sx = _mm_set1_ps(b->px[self]), sy = _mm_set1_ps(b->py[self]);
+    const __m128 minD2 = _mm_set1_ps(SEPARATION_MIN_D2), two = _mm_set1_ps(2.0f);
+    const __m128i vcx = _mm_set1_epi32(cx), vcy = _mm_set1_epi32(cy);
+    const __m128i lane = _mm_setr_epi32(0, 1, 2, 3), vself = _mm_set1_epi32(self);
+    __m128 vX = _mm_setzero_ps(), vY = _mm_setzero_ps();
+    __m128 pX = _mm_setzero_ps(), pY = _mm_setzero_ps();
+    __m128 sX = _mm_setzero_ps(), sY = _mm_setzero_ps();
+    __m128i count = _mm_setzero_si128();
+
+    for (; z + 4 <= end; z += 4){
+      __m128i in = _mm_and_si128(
+        _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(b->cellX + z)), vcx),
+        _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(b->cellY + z)), vcy));
+      in = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_add_epi32(_mm_set1_epi32(z), lane), vself), in);
+      __m128 m = _mm_castsi128_ps(in);
+      count = _mm_sub_epi32(count, in);     // true lanes are -1
+
+      __m128 x = _mm_loadu_ps(b->px + z), y = _mm_loadu_ps(b->py + z);
+      vX = _mm_add_ps(vX, _mm_and_ps(m, _mm_loadu_ps(b->vx + z)));
+      vY = _mm_add_ps(vY, _mm_and_ps(m, _mm_loadu_ps(b->vy + z)));
+      pX = _mm_add_ps(pX, _mm_and_ps(m, x));
+      pY = _mm_add_ps(pY, _mm_and_ps(m, y));
+
+      // 1/d^2 from the reciprocal estimate and one Newton step, no divide
+      __m128 dx = _mm_sub_ps(sx, x), dy = _mm_sub_ps(sy, y);
+      __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+      __m128 r = _mm_rcp_ps(d2);
+      r = _mm_mul_ps(r, _mm_sub_ps(two, _mm_mul_ps(d2, r)));
+      __m128 sm = _mm_and_ps(m, _mm_cmpgt_ps(d2, minD2));
+      sX = _mm_add_ps(sX, _mm_and_ps(sm, _mm_mul_ps(dx, r)));
+      sY = _mm_add_ps(sY, _mm_and_ps(sm, _mm_mul_ps(dy, r)));
+    }
+
+    int lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, count);
+    s->count += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    s->velX += hsum(vX);
+    s->velY += hsum(vY);
+    s->posX += hsum(pX);
+    s->posY += hsum(pY);
+    s->sepX += hsum(sX);
+    s->sepY += hsum(sY);
+  }
+  accumulateScalar(b, z, end, cx, cy, self, s);
+}
+
+#elif defined(FLOCK_NEON)
+
+static inline float hsum(float32x4_t v){
+  float32x2_t p = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+  return vget_lane_f32(vpadd_f32(p, p), 0);
+}
+
+void flockAccumulate(const flockBirds *b, int begin, int end, int cx, int cy,
+                     int self, flockSums *s){
+  int z = begin;
+  if (end - begin >= 4){
+    const float32x4_t sx = vdupq_n_f32(b->px[self]), sy = vdupq_n_f32(b->py[self]);
+    const float32x4_t minD2 = vdupq_n_f32(SEPARATION_MIN_D2);
+    const int32x4_t vcx = vdupq_n_s32(cx), vcy = vdupq_n_s32(cy), vself = vdupq_n_s32(self);
+    const int32_t laneInit[4] = { 0, 1, 2, 3 };
+    const int32x4_t lane = vld1q_s32(laneInit);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    float32x4_t vX = zero, vY = zero, pX = zero, pY = zero, sX = zero, sY = zero;
+    uint32x4_t count = vdupq_n_u32(0);
+
+    for (; z + 4 <= end; z += 4){
+      uint32x4_t in = vandq_u32(vceqq_s32(vld1q_s32(b->cellX + z), vcx),
+                                vceqq_s32(vld1q_s32(b->cellY + z), vcy));
+      in = vbicq_u32(in, vceqq_s32(vaddq_s32(vdupq_n_s32(z), lane), vself));
+      count = vsubq_u32(count, in);         // true lanes are all ones, i.e. -1
+
+      float32x4_t x = vld1q_f32(b->px + z), y = vld1q_f32(b->py + z);
+      vX = vaddq_f32(vX, vbslq_f32(in, vld1q_f32(b->vx + z), zero));
+      vY = vaddq_f32(vY, vbslq_f32(in, vld1q_f32(b->vy + z), zero));
+      pX = vaddq_f32(pX, vbslq_f32(in, x, zero));
+      pY = vaddq_f32(pY, vbslq_f32(in, y, zero));
+
+      // 1/d^2 from the reciprocal estimate and one Newton step, no divide
+      float32x4_t dx = vsubq_f32(sx, x), dy = vsubq_f32(sy, y);
+      float32x4_t d2 = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+      float32x4_t r = vrecpeq_f32(d2);
+      r = vmulq_f32(r, vrecpsq_f32(d2, r));
+      uint32x4_t sm = vandq_u32(in, vcgtq_f32(d2, minD2));
+      sX = vaddq_f32(sX, vbslq_f32(sm, vmulq_f32(dx, r), zero));
+      sY = vaddq_f32(sY, vbslq_f32(sm, vmulq_f32(dy, r), zero));
+    }
+
+    uint32_t lanes[4];
+    vst1q_u32(lanes, count);
+    s->count += (int)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    s->velX += hsum(vX);
+    s->velY += hsum(vY);
+    s->posX += hsum(pX);
+    s->posY += hsum(pY);
+    s->sepX += hsum(sX);
+    s->sepY += hsum(sY);
+  }
+  accumulateScalar(b, z, end, cx, cy, self, s);
+}
+
+#else
+
+void flockAccumulate(const flockBirds *b, int begin, int end, int cx, int cy,
+                     int self, flockSums *s){
+  accumulateScalar(b, begin, end, cx, cy, self, s);
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef FLOCK_H
+#define FLOCK_H
+
+// Flocking neighbour sums over bird kinematics kept as separate x/y arrays
+// in cell grid slot order. The kernel runs four lanes at a time with SSE2
+// or NEON where the target has them, and one bird at a time otherwise.
+typedef struct flockBirds{
+  float *px, *py;
+  float *vx, *vy;
+  const int *cellX, *cellY;   // cell of each slot, owned by the cell grid
+  int cap;
+} flockBirds;
+
+typedef struct flockSums{
+  float velX, velY;
+  float posX, posY;
+  float sepX, sepY;           // sum of (self - other) / |self - other|^2
+  int count;
+} flockSums;
+
+extern void flockReserve(flockBirds *b, int n);
+extern void flockRelease(flockBirds *b);
+
+// Adds every bird in slots [begin, end) that sits in cell (cx, cy), except
+// slot `self`, to `sums`. Separation skips birds closer than 0.001.
+extern void flockAccumulate(const flockBirds *b, int begin, int end, int cx, int cy,
+                            int self, flockSums *sums);
+
+#endif
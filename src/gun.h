@@ -15,6 +15,8 @@ typedef struct{
     int numberOfProjectiles;
     float damage; 
     float speed; 
+
+    int sound;      // sfxId of a shot
 } Gun;
 
 
@@ -9,6 +9,12 @@
  * 	   and a value copy function.  These enable you to use values
  * 	   that are themselves complex data structures.
  *
+ * 	   Tree nodes are carved out of per-hash slabs and keys are
+ * 	   copied inline into the node (or into a per-hash key block
+ * 	   when too long), so building a hash costs one malloc per
+ * 	   SLABNODES members rather than a malloc+strdup per member,
+ * 	   and hashFree() releases whole slabs at once.
+ *
  * (C) Duncan C. White, 1996-2013 although it seems longer:-)
  */
 
@@ -21,9 +27,14 @@
 
 
 #define	NHASH	32533
+#define	SLABNODES	1024			/* tree nodes per slab */
+#define	INLINEKEY	16			/* keys shorter than this live in the node */
+#define	KEYBLOCK	16384			/* bytes per out-of-line key block */
 
 
 typedef struct tree_s *tree;
+typedef struct slab_s *slab;
+typedef struct keyblock_s *keyblock;
 
 
 struct hash_s {
@@ -31,13 +42,32 @@ struct hash_s {
 	hashprintfunc	p;			/* how to print (k,v) pair */
 	hashfreefunc	f;			/* how to free a value  */
 	hashcopyfunc	c;			/* how to copy a value  */
+	slab		slabs;			/* node slabs, newest first */
+	keyblock	keys;			/* long key storage, newest first */
+	int		n;			/* number of members */
 };
 
 struct tree_s {
-	hashkey		k;			/* Key */
+	hashkey		k;			/* Key (points at inl or a keyblock) */
 	hashvalue   	v;			/* Value */
 	tree		left;			/* Left... */
 	tree		right;			/* ... and Right trees */
+	hashcode	hc;			/* full hash of the key */
+	int		klen;			/* key length, excluding the NUL */
+	char		inl[INLINEKEY];		/* inline key storage */
+};
+
+struct slab_s {
+	slab		next;
+	int		used;
+	struct tree_s	node[SLABNODES];
+};
+
+struct keyblock_s {
+	keyblock	next;
+	int		used;
+	int		cap;
+	char		data[];
 };
 
 
@@ -51,13 +81,13 @@ typedef enum { Search, Define } tree_operation;
 
 static void foreach_tree( tree, hashforeachcb, void * );
 static void dump_cb( hashkey, hashvalue, void * );
-static void free_tree( tree, hashfreefunc );
+static void free_values( hash );
 static void freevalue( hashfreefunc, hashvalue );
-static tree copy_tree( tree, hashcopyfunc );
+static void free_slabs( hash );
+static tree copy_tree( hash, tree, hashcopyfunc );
 static int depth_tree( tree );
-static tree tree_op( hash, hashkey, hashvalue, tree_operation );
-static tree talloc( hashkey, hashvalue );
-static int shash( char * );
+static tree tree_op( hash, hashcode, const char *, int, hashvalue, tree_operation );
+static tree talloc( hash, hashcode, const char *, int, hashvalue );
 
 
 /*
@@ -75,6 +105,9 @@ hash hashCreate( hashprintfunc p, hashfreefunc f, hashcopyfunc c )
 	h->f = f;
 	h->p = p;
 	h->c = c;
+	h->slabs = NULL;
+	h->keys = NULL;
+	h->n = 0;
 
 	for( i = 0; i < NHASH; i++ )
 	{
@@ -92,13 +125,11 @@ void hashEmpty( hash a )
 {
 	int   i;
 
+	free_values( a );
+	free_slabs( a );
 	for( i = 0; i < NHASH; i++ )
 	{
-		if( a->data[i] != NULL )
-		{
-			free_tree( a->data[i], a->f );
-			a->data[i] = NULL;
-		}
+		a->data[i] = NULL;
 	}
 }
 
@@ -116,13 +147,16 @@ hash hashCopy( hash h )
 	result->p = h->p;
 	result->f = h->f;
 	result->c = h->c;
+	result->slabs = NULL;
+	result->keys = NULL;
+	result->n = 0;
 
 	for( i = 0; i < NHASH; i++ )
 	{
 		result->data[i] = NULL;
 		if( h->data[i] != NULL )
 		{
-			result->data[i] = copy_tree( h->data[i], h->c );
+			result->data[i] = copy_tree( result, h->data[i], h->c );
 		}
 	}
 
@@ -135,15 +169,8 @@ hash hashCopy( hash h )
  */
 void hashFree( hash h )
 {
-	int   i;
-
-	for( i = 0; i < NHASH; i++ )
-	{
-		if( h->data[i] != NULL )
-		{
-			free_tree( h->data[i], h->f );
-		}
-	}
+	free_values( h );
+	free_slabs( h );
 
 	free( (hashvalue) h->data );
 	free( (hashvalue) h );
@@ -155,7 +182,17 @@ void hashFree( hash h )
  */
 void hashSet( hash h, hashkey k, hashvalue v )
 {
-	(void) tree_op( h, k, v, Define);
+	int len = strlen( k );
+	(void) tree_op( h, hashCode( k, len ), k, len, v, Define);
+}
+
+
+/*
+ * Add k->v to the hash h, k being a len-byte view hashing to hc
+ */
+void hashSetKey( hash h, hashcode hc, const char *k, int len, hashvalue v )
+{
+	(void) tree_op( h, hc, k, len, v, Define);
 }
 
 
@@ -167,7 +204,8 @@ void hashSet( hash h, hashkey k, hashvalue v )
  */
 int hashPresent( hash h, hashkey k, hashvalue *v )
 {
-	tree x = tree_op(h, k, 0, Search);
+	int  len = strlen( k );
+	tree x = tree_op(h, hashCode( k, len ), k, len, 0, Search);
 	if( x == NULL )
 	{
 		*v = (hashvalue)-1;
@@ -183,7 +221,19 @@ int hashPresent( hash h, hashkey k, hashvalue *v )
  */
 hashvalue hashFind( hash h, hashkey k )
 {
-	tree x = tree_op(h, k, 0, Search);
+	int  len = strlen( k );
+	tree x = tree_op(h, hashCode( k, len ), k, len, 0, Search);
+
+	return ( x == NULL ) ? (hashvalue) NULL : x->v;
+}
+
+
+/*
+ * Look for a len-byte key view, hashing to hc, in the hash h
+ */
+hashvalue hashFindKey( hash h, hashcode hc, const char *k, int len )
+{
+	tree x = tree_op(h, hc, k, len, 0, Search);
 
 	return ( x == NULL ) ? (hashvalue) NULL : x->v;
 }
@@ -243,24 +293,94 @@ void hashDump( FILE *out, hash h )
 
 
 /*
- * Allocate a new node in the tree
+ * Copy a len-byte key into storage owned by h: short keys go inline
+ * in the node, longer ones are appended to the current key block.
+ */
+static char *kalloc( hash h, tree p, const char *k, int len )
+{
+	keyblock b = h->keys;
+	char *   dst;
+
+	if( len < INLINEKEY )
+	{
+		dst = p->inl;
+	} else
+	{
+		if( b == NULL || b->used + len + 1 > b->cap )
+		{
+			int cap = len + 1 > KEYBLOCK ? len + 1 : KEYBLOCK;
+			b = (keyblock) malloc( sizeof(struct keyblock_s) + cap );
+			if( b == NULL )
+			{
+				fprintf( stderr, "kalloc: No space left\n" );
+				exit(1);
+			}
+			b->used = 0;
+			b->cap  = cap;
+			b->next = h->keys;
+			h->keys = b;
+		}
+		dst = b->data + b->used;
+		b->used += len + 1;
+	}
+	memcpy( dst, k, len );
+	dst[len] = '\0';
+	return dst;
+}
+
+
+/*
+ * Allocate a new node in the tree, from h's current slab
  */
-static tree talloc( hashkey k, hashvalue v )
+static tree talloc( hash h, hashcode hc, const char *k, int len, hashvalue v )
 {
-	tree   p = (tree) malloc(sizeof(struct tree_s));
+	slab   s = h->slabs;
+	tree   p;
 
-	if( p == NULL )
+	if( s == NULL || s->used == SLABNODES )
 	{
-		fprintf( stderr, "talloc: No space left\n" );
-		exit(1);
+		s = (slab) malloc(sizeof(struct slab_s));
+		if( s == NULL )
+		{
+			fprintf( stderr, "talloc: No space left\n" );
+			exit(1);
+		}
+		s->used = 0;
+		s->next = h->slabs;
+		h->slabs = s;
 	}
+	p = &s->node[s->used++];
 	p->left = p->right = NULL;
-	p->k    = strdup(k);		/* Save key */
+	p->hc   = hc;
+	p->klen = len;
+	p->k    = kalloc( h, p, k, len );	/* Save key */
 	p->v    = v;			/* value */
+	h->n++;
 	return p;
 }
 
 
+/*
+ * Release every slab and key block owned by h
+ */
+static void free_slabs( hash h )
+{
+	while( h->slabs != NULL )
+	{
+		slab next = h->slabs->next;
+		free( (hashvalue) h->slabs );
+		h->slabs = next;
+	}
+	while( h->keys != NULL )
+	{
+		keyblock next = h->keys->next;
+		free( (hashvalue) h->keys );
+		h->keys = next;
+	}
+	h->n = 0;
+}
+
+
 /*
  * Hash metrics:
  *  calculate the min, max and average depth of all non-empty trees
@@ -292,17 +412,11 @@ void hashMetrics( hash h, int *min, int *max, double *avg )
 
 /*
  * Hash members: how many members in the Hash?
+ *  nodes are never removed individually, so a running count suffices
  */
-static void count_cb( hashkey k, hashvalue v, void *arg )
-{
-	int *n = (int *)arg;
-	(*n)++;
-}
 int hashMembers( hash h )
 {
-	int n = 0;
-	hashForeach( h, &count_cb, (void *)&n );
-	return n;
+	return h->n;
 }
 
 /*
@@ -313,18 +427,33 @@ int hashIsEmpty( hash h )
 	return hashMembers( h ) == 0;
 }
 
+/*
+ * Order two keys: by full hash first (cheap and nearly always decisive),
+ * then bytewise, then by length.
+ */
+static int keycmp( tree t, hashcode hc, const char *k, int len )
+{
+	int rc;
+
+	if( t->hc != hc ) return t->hc < hc ? -1 : 1;
+	rc = memcmp( t->k, k, t->klen < len ? t->klen : len );
+	if( rc != 0 ) return rc;
+	return t->klen - len;
+}
+
+
 /*
  * Operate on the binary search tree
  * Search, Define.
  */
-static tree tree_op( hash h, hashkey k, hashvalue v, tree_operation op )
+static tree tree_op( hash h, hashcode hc, const char *k, int len, hashvalue v, tree_operation op )
 {
 	tree	ptr;
-	tree *	aptr = h->data + shash(k);
+	tree *	aptr = h->data + hc % NHASH;
 
 	while( (ptr = *aptr) != NULL )
 	{
-		int rc = strcmp(ptr->k, k);
+		int rc = keycmp( ptr, hc, k, len );
 		if( rc == 0 )
 		{
 			if (op == Define)
@@ -349,7 +478,7 @@ static tree tree_op( hash h, hashkey k, hashvalue v, tree_operation op )
 
 	if (op == Define)
 	{
-		return *aptr = talloc(k,v);	/* Alloc new node */
+		return *aptr = talloc(h,hc,k,len,v);	/* Alloc new node */
 	}
 
 	return NULL;				/* not found */
@@ -357,17 +486,17 @@ static tree tree_op( hash h, hashkey k, hashvalue v, tree_operation op )
 
 
 /*
- * Copy one tree
+ * Copy one tree, allocating the new nodes from h
  */
-static tree copy_tree( tree t, hashcopyfunc c )
+static tree copy_tree( hash h, tree t, hashcopyfunc c )
 {
 	tree result = NULL;
 	if( t )
 	{
 		hashvalue v = c != NULL ? (*c)(t->v) : t->v;
-		result = talloc( t->k, v );
-		result->left  = copy_tree( t->left, c );
-		result->right = copy_tree( t->right, c );
+		result = talloc( h, t->hc, t->k, t->klen, v );
+		result->left  = copy_tree( h, t->left, c );
+		result->right = copy_tree( h, t->right, c );
 	}
 	return result;
 }
@@ -390,17 +519,20 @@ static void foreach_tree( tree t, hashforeachcb f, void * arg )
 
 
 /*
- * Free one tree
+ * Free every value in h: all nodes live in slabs, so walk the slabs
+ * linearly rather than chasing the trees
  */
-static void free_tree( tree t, hashfreefunc f )
+static void free_values( hash h )
 {
-	if( t )
+	slab	s;
+	int	i;
+
+	for( s = h->slabs; s != NULL; s = s->next )
 	{
-		free_tree( t->left, f );
-		free_tree( t->right, f );
-		freevalue( f, t->v );
-		free( (hashvalue) t->k );
-		free( (hashvalue) t );
+		for( i = 0; i < s->used; i++ )
+		{
+			freevalue( h->f, s->node[i].v );
+		}
 	}
 }
 
@@ -434,12 +566,12 @@ static int depth_tree( tree t )
 
 
 /*
- * Calculate hash on a string
+ * Calculate hash on a len-byte key
  */
-static int shash( char *str )
+hashcode hashCode( const char *k, int len )
 {
-	unsigned char	ch;
+	const unsigned char *str = (const unsigned char *) k;
 	unsigned int	hh;
-	for (hh = 0; (ch = *str++) != '\0'; hh = hh * 65599 + ch );
-	return hh % NHASH;
+	for (hh = 0; len-- > 0; hh = hh * 65599 + *str++ );
+	return hh;
 }
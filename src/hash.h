@@ -10,6 +10,7 @@
 typedef struct hash_s *hash;
 typedef void *hashvalue;
 typedef char *hashkey;
+typedef unsigned int hashcode;
 
 typedef void (*hashprintfunc)( FILE *, hashkey, hashvalue );
 typedef void (*hashforeachcb)( hashkey, hashvalue, void * );
@@ -28,5 +29,16 @@ extern void hashDump( FILE * out, hash h );
 extern int hashMembers( hash h );
 extern int hashIsEmpty( hash h );
 
+/*
+ * Allocation-free key path: the caller supplies the key as a view
+ * (pointer + length, no NUL needed) together with its hashCode(), so
+ * hot loops can format a key into a stack buffer, hash it once and
+ * reuse the code.  Keys set this way are interchangeable with the
+ * plain string API above.
+ */
+extern hashcode hashCode( const char * k, int len );
+extern void hashSetKey( hash h, hashcode hc, const char * k, int len, hashvalue v );
+extern hashvalue hashFindKey( hash h, hashcode hc, const char * k, int len );
+
 /*  calculate the min, max and average depth of all non-empty trees */
 extern void hashMetrics( hash h, int * min, int * max, double * avg );
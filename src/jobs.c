@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "jobs.h"
+
+#if !defined(PLATFORM_WEB)
+#include <pthread.h>
+#include <sched.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#define JOBS_THREADED
+#endif
+
+#define JOBS_MAX_WORKERS 7
+#define JOBS_MAX_CALLERS 4        // threads that may be inside jobsRun at once
+#define JOBS_DEQUE_CAP 128
+
+// One jobsRun call, on its caller's stack
+typedef struct jobBatch{
+  int remaining;          // indices not run yet, under pool.lock
+} jobBatch;
+
+// A range of one task's indices. Chunks carry everything needed to run
+// them, so whichever thread ends up with one doesn't care where it came from.
+typedef struct jobChunk{
+  jobBatch *batch;
+  jobrangefunc fn;
+  void *ctx;
+  int begin, end;
+  int grain;
+} jobChunk;
+
+typedef struct jobRangeOfIndices{
+  jobfunc fn;
+  void *ctx;
+} jobRangeOfIndices;
+
+static void runIndices(void *ctx, int begin, int end){
+  jobRangeOfIndices *r = ctx;
+  for (int i = begin; i < end; i++)
+    r->fn(r->ctx, i);
+}
+
+void jobsParallelRange(int count, int grain, jobrangefunc fn, void *ctx){
+  jobTask task = { count, grain, fn, ctx };
+  jobsRun(&task, 1);
+}
+
+void jobsParallelFor(int count, jobfunc fn, void *ctx){
+  jobRangeOfIndices r = { fn, ctx };
+  jobsParallelRange(count, 1, &runIndices, &r);
+}
+
+#ifdef JOBS_THREADED
+
+// The owner pushes and pops at the bottom, thieves take from the top where
+// the oldest and so largest ranges are
+typedef struct jobDeque{
+  pthread_mutex_t lock;
+  jobChunk items[JOBS_DEQUE_CAP];
+  int top, bottom;
+} jobDeque;
+
+// Batches from different threads (the game loop and the level loader)
+// share the workers; each caller gets a deque of its own for the batch.
+static struct{
+  pthread_mutex_t lock;
+  pthread_cond_t work;
+  pthread_cond_t callerFree;
+  pthread_t threads[JOBS_MAX_WORKERS];
+  int workers;
+  bool quit;
+
+  unsigned generation;    // bumped for every batch to wake the workers
+  bool callerBusy[JOBS_MAX_CALLERS];
+  // callers' deques first, then one per worker
+  jobDeque deques[JOBS_MAX_CALLERS + JOBS_MAX_WORKERS];
+} pool = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .work = PTHREAD_COND_INITIALIZER,
+  .callerFree = PTHREAD_COND_INITIALIZER,
+};
+
+static pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+
+static int cpuCount(void){
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (int)info.dwNumberOfProcessors;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+#endif
+}
+
+static bool dequePush(jobDeque *d, jobChunk c){
+  pthread_mutex_lock(&d->lock);
+  bool ok = d->bottom < JOBS_DEQUE_CAP;
+  if (ok) d->items[d->bottom++] = c;
+  pthread_mutex_unlock(&d->lock);
+  return ok;
+}
+
+// With `only` set, a thief takes the top chunk only if it is of that batch
+static bool dequeTake(jobDeque *d, jobChunk *c, bool fromTop, const jobBatch *only){
+  pthread_mutex_lock(&d->lock);
+  bool ok = d->bottom > d->top && (only == NULL || d->items[d->top].batch == only);
+  if (ok) *c = fromTop ? d->items[d->top++] : d->items[--d->bottom];
+  if (d->top == d->bottom) d->top = d->bottom = 0;
+  pthread_mutex_unlock(&d->lock);
+  return ok;
+}
+
+// Workers take any batch's chunks. Callers only take their own, so the
+// game loop never ends up running a slice of a level build.
+static bool findChunk(int self, jobChunk *c, const jobBatch *only){
+  if (dequeTake(&pool.deques[self], c, false, NULL)) return true;
+  int n = JOBS_MAX_CALLERS + pool.workers;
+  for (int i = 1; i < n; i++){
+    if (dequeTake(&pool.deques[(self + i) % n], c, true, only)) return true;
+  }
+  return false;
+}
+
+static void runChunk(int self, jobChunk c){
+  // Keep the lower half, leave the upper half where it can be stolen
+  while (c.end - c.begin > c.grain){
+    jobChunk upper = c;
+    upper.begin = c.begin + (c.end - c.begin) / 2;
+    if (!dequePush(&pool.deques[self], upper)) break;
+    c.end = upper.begin;
+  }
+  c.fn(c.ctx, c.begin, c.end);
+
+  pthread_mutex_lock(&pool.lock);
+  c.batch->remaining -= c.end - c.begin;
+  pthread_mutex_unlock(&pool.lock);
+}
+
+// Caller: run and steal chunks until its batch is done, including the
+// chunks other threads are still in the middle of
+static void helpUntilDone(int self, jobBatch *batch){
+  jobChunk c;
+  for (;;){
+    if (findChunk(self, &c, batch)){
+      runChunk(self, c);
+      continue;
+    }
+    pthread_mutex_lock(&pool.lock);
+    bool live = batch->remaining > 0;
+    pthread_mutex_unlock(&pool.lock);
+    if (!live) return;
+    sched_yield();
+  }
+}
+
+static void *workerMain(void *arg){
+  int self = (int)(intptr_t)arg;
+  unsigned seen = 0;
+  pthread_mutex_lock(&pool.lock);
+  for (;;){
+    while (!pool.quit && pool.generation == seen)
+      pthread_cond_wait(&pool.work, &pool.lock);
+    if (pool.quit) break;
+    seen = pool.generation;
+    pthread_mutex_unlock(&pool.lock);
+    jobChunk c;
+    while (findChunk(self, &c, NULL))
+      runChunk(self, c);
+    pthread_mutex_lock(&pool.lock);
+  }
+  pthread_mutex_unlock(&pool.lock);
+  return NULL;
+}
+
+static void poolStart(void){
+  for (int i = 0; i < JOBS_MAX_CALLERS + JOBS_MAX_WORKERS; i++)
+    pthread_mutex_init(&pool.deques[i].lock, NULL);
+
+  int n = cpuCount() - 1;
+  if (n > JOBS_MAX_WORKERS) n = JOBS_MAX_WORKERS;
+  for (int i = 0; i < n; i++){
+    if (pthread_create(&pool.threads[i], NULL, &workerMain, (void *)(intptr_t)(JOBS_MAX_CALLERS + i)) != 0) break;
+    pool.workers++;
+  }
+}
+
+void jobsRun(const jobTask *tasks, int taskCount){
+  int total = 0;
+  for (int t = 0; t < taskCount; t++)
+    if (tasks[t].count > 0) total += tasks[t].count;
+  if (total == 0) return;
+  pthread_once(&poolOnce, &poolStart);
+
+  jobBatch batch = { total };
+  int self = -1;
+  pthread_mutex_lock(&pool.lock);
+  for (;;){
+    for (int i = 0; i < JOBS_MAX_CALLERS && self < 0; i++){
+      if (!pool.callerBusy[i]) self = i;
+    }
+    if (self >= 0) break;
+    pthread_cond_wait(&pool.callerFree, &pool.lock);
+  }
+  pool.callerBusy[self] = true;
+  pthread_mutex_unlock(&pool.lock);
+
+  // Whole tasks go on the caller's deque; stealing spreads them out
+  for (int t = 0; t < taskCount; t++){
+    if (tasks[t].count <= 0) continue;
+    jobChunk c = { &batch, tasks[t].fn, tasks[t].ctx, 0, tasks[t].count,
+                   tasks[t].grain > 0 ? tasks[t].grain : 1 };
+    if (!dequePush(&pool.deques[self], c)) runChunk(self, c);
+  }
+
+  pthread_mutex_lock(&pool.lock);
+  pool.generation++;
+  pthread_cond_broadcast(&pool.work);
+  pthread_mutex_unlock(&pool.lock);
+
+  helpUntilDone(self, &batch);
+
+  pthread_mutex_lock(&pool.lock);
+  pool.callerBusy[self] = false;
+  pthread_cond_signal(&pool.callerFree);
+  pthread_mutex_unlock(&pool.lock);
+}
+
+int jobsThreadCount(void){
+  pthread_once(&poolOnce, &poolStart);
+  return pool.workers + 1;
+}
+
+void jobsShutdown(void){
+  pthread_mutex_lock(&pool.lock);
+  pool.quit = true;
+  pthread_cond_broadcast(&pool.work);
+  pthread_mutex_unlock(&pool.lock);
+  for (int i = 0; i < pool.workers; i++)
+    pthread_join(pool.threads[i], NULL);
+  pool.workers = 0;
+}
+
+#else
+
+void jobsRun(const jobTask *tasks, int taskCount){
+  for (int t = 0; t < taskCount; t++){
+    if (tasks[t].count > 0) tasks[t].fn(tasks[t].ctx, 0, tasks[t].count);
+  }
+}
+
+int jobsThreadCount(void){
+  return 1;
+}
+
+void jobsShutdown(void){
+}
+
+#endif
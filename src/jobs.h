@@ -0,0 +1,34 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+// Small pool of worker threads for data-parallel loops. Work is cut into
+// index ranges that sit on per-thread deques: a thread splits its own
+// range in half until it is down to the grain size, and idle threads
+// steal the big halves from the other end. The calling thread helps out
+// and only returns once every index has been run, so a call is also the
+// barrier between one phase of a frame and the next. Several threads may
+// run batches at once; a caller only ever runs chunks of its own batch, so
+// a long batch elsewhere can slow it down but never block it. Don't call
+// these from inside a job. Web builds have no threads and simply run in
+// order.
+typedef void (*jobfunc)(void *ctx, int index);
+typedef void (*jobrangefunc)(void *ctx, int begin, int end);
+
+// One parallel loop: fn is called on disjoint [begin, end) ranges that
+// together cover [0, count), none longer than grain unless the deques fill.
+typedef struct jobTask{
+  int count;
+  int grain;
+  jobrangefunc fn;
+  void *ctx;
+} jobTask;
+
+// Runs several independent loops as one batch, so a short loop doesn't
+// leave the pool idle while the others finish.
+extern void jobsRun(const jobTask *tasks, int taskCount);
+extern void jobsParallelRange(int count, int grain, jobrangefunc fn, void *ctx);
+extern void jobsParallelFor(int count, jobfunc fn, void *ctx);
+extern int jobsThreadCount(void);   // workers plus the caller
+extern void jobsShutdown(void);
+
+#endif
@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "raylib.h"
+#include "rlgl.h"
+#include "lighting.h"
+
+#define MASK_SIZE (CHUNK_SIZE + 2 * LIGHTING_MASK_MARGIN)
+
+typedef struct light{
+  Vector2 pos;
+  float radius;
+  Vector2 dir;
+  float cosHalf;     // -1 for point lights
+  Color col;
+} light;
+
+typedef struct lighting{
+  bool enabled;
+  RenderTexture2D target;
+  Shader shader;
+  Texture2D white;          // 1x1 quad texture so fragTexCoord spans each light
+  Texture2D mask;           // one texel per tile, white = wall
+  unsigned char maskPixels[MASK_SIZE * MASK_SIZE];
+  tilemap maskMap;
+  int maskX, maskY;         // room the mask was built for
+  bool maskValid;
+
+  int lightRectLoc, lightPosLoc, lightRadiusLoc, lightDirLoc, lightCosHalfLoc;
+  int lightColorLoc, maskLoc, maskRectLoc;
+
+  light lights[LIGHTING_MAX_LIGHTS];
+  int count;
+} lighting;
+
+static lighting s_light = {0};
+
+void lightingInit(int width, int height){
+  s_light.target = LoadRenderTexture(width, height);
+  s_light.shader = LoadShader(0, "shaders/light.fs");
+  s_light.enabled = s_light.shader.id != rlGetShaderIdDefault();
+  if (!s_light.enabled){
+    TraceLog(LOG_WARNING, "Light shader unavailable, torches are drawn unshadowed");
+    return;
+  }
+
+  Image white = GenImageColor(1, 1, WHITE);
+  s_light.white = LoadTextureFromImage(white);
+  UnloadImage(white);
+
+  Image mask = {
+    .data = s_light.maskPixels, .width = MASK_SIZE, .height = MASK_SIZE,
+    .mipmaps = 1, .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE
+  };
+  s_light.mask = LoadTextureFromImage(mask);
+
+  s_light.lightRectLoc = GetShaderLocation(s_light.shader, "lightRect");
+  s_light.lightPosLoc = GetShaderLocation(s_light.shader, "lightPos");
+  s_light.lightRadiusLoc = GetShaderLocation(s_light.shader, "lightRadius");
+  s_light.lightDirLoc = GetShaderLocation(s_light.shader, "lightDir");
+  s_light.lightCosHalfLoc = GetShaderLocation(s_light.shader, "lightCosHalf");
+  s_light.lightColorLoc = GetShaderLocation(s_light.shader, "lightColor");
+  s_light.maskLoc = GetShaderLocation(s_light.shader, "wallMask");
+  s_light.maskRectLoc = GetShaderLocation(s_light.shader, "wallMaskRect");
+}
+
+void lightingUnload(void){
+  UnloadRenderTexture(s_light.target);
+  if (s_light.enabled){
+    UnloadShader(s_light.shader);
+    UnloadTexture(s_light.white);
+    UnloadTexture(s_light.mask);
+  }
+  memset(&s_light, 0, sizeof(s_light));
+}
+
+bool lightingEnabled(void){
+  return s_light.enabled;
+}
+
+// Walls only change with the level, so the mask is rebuilt per room rather
+// than per frame and the GPU reads it as a texture.
+void lightingSetRoom(tilemap map, int cx, int cy){
+  if (!s_light.enabled) return;
+  if (s_light.maskValid && s_light.maskMap == map && s_light.maskX == cx && s_light.maskY == cy) return;
+
+  int x0 = cx * CHUNK_SIZE - LIGHTING_MASK_MARGIN;
+  int y0 = cy * CHUNK_SIZE - LIGHTING_MASK_MARGIN;
+  for (int y = 0; y < MASK_SIZE; y++)
+    for (int x = 0; x < MASK_SIZE; x++)
+      s_light.maskPixels[y * MASK_SIZE + x] = mapBlocksSight(map, x0 + x, y0 + y) ? 255 : 0;
+  UpdateTexture(s_light.mask, s_light.maskPixels);
+
+  s_light.maskMap = map;
+  s_light.maskX = cx;
+  s_light.maskY = cy;
+  s_light.maskValid = true;
+}
+
+void lightingInvalidate(void){
+  s_light.maskValid = false;
+}
+
+static void addLight(light l){
+  if (s_light.count >= LIGHTING_MAX_LIGHTS) return;
+  s_light.lights[s_light.count++] = l;
+}
+
+void lightingAddCone(Vector2 pos, float angle, float fov, float radius, Color col){
+  addLight((light){ pos, radius, (Vector2){ cosf(angle), sinf(angle) }, cosf(fov / 2), col });
+}
+
+void lightingAddPoint(Vector2 pos, float radius, Color col){
+  addLight((light){ pos, radius, (Vector2){ 1, 0 }, -1.0f, col });
+}
+
+void lightingRender(Camera2D camera){
+  BeginTextureMode(s_light.target);
+    ClearBackground(BLACK);
+    if (s_light.enabled && s_light.count > 0 && s_light.maskValid){
+      float maskRect[4] = {
+        (float)((s_light.maskX * CHUNK_SIZE - LIGHTING_MASK_MARGIN) * TILE_SIZE),
+        (float)((s_light.maskY * CHUNK_SIZE - LIGHTING_MASK_MARGIN) * TILE_SIZE),
+        (float)(MASK_SIZE * TILE_SIZE),
+        (float)(MASK_SIZE * TILE_SIZE)
+      };
+      BeginMode2D(camera);
+      BeginBlendMode(BLEND_ADDITIVE);
+      BeginShaderMode(s_light.shader);
+      SetShaderValue(s_light.shader, s_light.maskRectLoc, maskRect, SHADER_UNIFORM_VEC4);
+      for (int i = 0; i < s_light.count; i++){
+        light *l = &s_light.lights[i];
+        Rectangle quad = { l->pos.x - l->radius, l->pos.y - l->radius, l->radius * 2, l->radius * 2 };
+        float rectV[4] = { quad.x, quad.y, quad.width, quad.height };
+        float colV[4] = { l->col.r / 255.0f, l->col.g / 255.0f, l->col.b / 255.0f, l->col.a / 255.0f };
+        SetShaderValue(s_light.shader, s_light.lightRectLoc, rectV, SHADER_UNIFORM_VEC4);
+        SetShaderValue(s_light.shader, s_light.lightPosLoc, &l->pos, SHADER_UNIFORM_VEC2);
+        SetShaderValue(s_light.shader, s_light.lightRadiusLoc, &l->radius, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(s_light.shader, s_light.lightDirLoc, &l->dir, SHADER_UNIFORM_VEC2);
+        SetShaderValue(s_light.shader, s_light.lightCosHalfLoc, &l->cosHalf, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(s_light.shader, s_light.lightColorLoc, colV, SHADER_UNIFORM_VEC4);
+        SetShaderValueTexture(s_light.shader, s_light.maskLoc, s_light.mask);
+        DrawTexturePro(s_light.white, (Rectangle){ 0, 0, 1, 1 }, quad, (Vector2){ 0, 0 }, 0.0f, WHITE);
+        // uniforms are not part of the batch, so each light is its own draw
+        rlDrawRenderBatchActive();
+      }
+      EndShaderMode();
+      EndBlendMode();
+      EndMode2D();
+    }
+  EndTextureMode();
+  s_light.count = 0;
+}
+
+Texture2D lightingTexture(void){
+  return s_light.target.texture;
+}
@@ -0,0 +1,42 @@
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include <stdbool.h>
+
+#include "raylib.h"
+#include "map.h"
+
+// Light accumulation pass. Lights are queued while the frame is drawn,
+// rendered additively into their own target by shaders/light.fs with
+// shadows from a wall mask of the current room, and the atmosphere shader
+// adds the result over the scene.
+#define LIGHTING_MAX_LIGHTS 64
+
+// Loads shaders/light.fs, so call it from inside the assets directory.
+extern void lightingInit(int width, int height);
+extern void lightingUnload(void);
+// False when the light shader did not compile; callers fall back to
+// drawing their lights straight into the scene.
+extern bool lightingEnabled(void);
+
+// Reach of an enemy torch in pixels.
+#define LIGHTING_TORCH_RADIUS 150
+
+// Rebuilds the wall mask when the player enters another room. The mask
+// covers the room and LIGHTING_MASK_MARGIN tiles of its neighbours, enough
+// for a torch at the room edge to find every wall it can reach.
+#define LIGHTING_MASK_MARGIN ((LIGHTING_TORCH_RADIUS + TILE_SIZE - 1) / TILE_SIZE)
+extern void lightingSetRoom(tilemap map, int cx, int cy);
+// The mask belongs to the previous map after a level swap.
+extern void lightingInvalidate(void);
+
+// `fov` is the full cone angle in radians, `angle` its facing.
+extern void lightingAddCone(Vector2 pos, float angle, float fov, float radius, Color col);
+extern void lightingAddPoint(Vector2 pos, float radius, Color col);
+
+// Draws the queued lights with the scene camera and empties the queue.
+// The target is cleared even when nothing is lit.
+extern void lightingRender(Camera2D camera);
+extern Texture2D lightingTexture(void);
+
+#endif
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "loader.h"
+
+#if !defined(PLATFORM_WEB)
+#include <pthread.h>
+#define LOADER_THREADED
+#endif
+
+// mapCreate keeps the whole tile grid on its stack, which is more than
+// some platforms give secondary threads by default.
+#define LOADER_STACK_SIZE (4 * 1024 * 1024)
+
+// Level numbers start at 1, so 0 means "none" below.
+struct levelLoader{
+  BIOME_DATA biome_data;
+  Texture2D pathDirt;
+  uint64_t worldSeed;
+
+  int wanted;       // queued for the worker
+  int building;     // being generated right now
+  int doneLevel;    // level held in `done`
+  mapData done;
+
+#ifdef LOADER_THREADED
+  bool quit;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t finished;
+#endif
+};
+
+#ifdef LOADER_THREADED
+
+static void *loaderMain(void *arg){
+  levelLoader l = arg;
+  pthread_mutex_lock(&l->lock);
+  for (;;){
+    while (!l->quit && l->wanted == 0)
+      pthread_cond_wait(&l->wake, &l->lock);
+    if (l->quit) break;
+
+    int level = l->wanted;
+    l->wanted = 0;
+    l->building = level;
+    pthread_mutex_unlock(&l->lock);
+
+    mapData d = mapCreate(l->biome_data, l->pathDirt, level, mapLevelSeed(l->worldSeed, level));
+
+    pthread_mutex_lock(&l->lock);
+    // a level nobody took in time has been superseded
+    if (l->doneLevel) mapFree(l->done);
+    l->done = d;
+    l->doneLevel = level;
+    l->building = 0;
+    pthread_cond_broadcast(&l->finished);
+  }
+  pthread_mutex_unlock(&l->lock);
+  return NULL;
+}
+
+levelLoader levelLoaderCreate(BIOME_DATA biome_data, Texture2D pathDirt, uint64_t worldSeed){
+  levelLoader l = calloc(1, sizeof(struct levelLoader));
+  assert(l != NULL);
+  l->biome_data = biome_data;
+  l->pathDirt = pathDirt;
+  l->worldSeed = worldSeed;
+  pthread_mutex_init(&l->lock, NULL);
+  pthread_cond_init(&l->wake, NULL);
+  pthread_cond_init(&l->finished, NULL);
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, LOADER_STACK_SIZE);
+  int rc = pthread_create(&l->thread, &attr, &loaderMain, l);
+  assert(rc == 0);
+  pthread_attr_destroy(&attr);
+  return l;
+}
+
+void levelLoaderRequest(levelLoader l, int level){
+  pthread_mutex_lock(&l->lock);
+  if (l->doneLevel != level && l->building != level){
+    l->wanted = level;
+    pthread_cond_signal(&l->wake);
+  }
+  pthread_mutex_unlock(&l->lock);
+}
+
+bool levelLoaderReady(levelLoader l, int level){
+  pthread_mutex_lock(&l->lock);
+  bool ready = (l->doneLevel == level);
+  pthread_mutex_unlock(&l->lock);
+  return ready;
+}
+
+mapData levelLoaderTake(levelLoader l, int level){
+  pthread_mutex_lock(&l->lock);
+  if (l->doneLevel != level && l->building != level && l->wanted != level){
+    l->wanted = level;
+    pthread_cond_signal(&l->wake);
+  }
+  while (l->doneLevel != level)
+    pthread_cond_wait(&l->finished, &l->lock);
+  mapData d = l->done;
+  l->doneLevel = 0;
+  pthread_mutex_unlock(&l->lock);
+  return d;
+}
+
+void levelLoaderFree(levelLoader l){
+  pthread_mutex_lock(&l->lock);
+  l->quit = true;
+  pthread_cond_signal(&l->wake);
+  pthread_mutex_unlock(&l->lock);
+  pthread_join(l->thread, NULL);
+
+  if (l->doneLevel) mapFree(l->done);
+  pthread_cond_destroy(&l->finished);
+  pthread_cond_destroy(&l->wake);
+  pthread_mutex_destroy(&l->lock);
+  free(l);
+}
+
+#else
+
+levelLoader levelLoaderCreate(BIOME_DATA biome_data, Texture2D pathDirt, uint64_t worldSeed){
+  levelLoader l = calloc(1, sizeof(struct levelLoader));
+  assert(l != NULL);
+  l->biome_data = biome_data;
+  l->pathDirt = pathDirt;
+  l->worldSeed = worldSeed;
+  return l;
+}
+
+void levelLoaderRequest(levelLoader l, int level){
+  l->wanted = level;
+}
+
+bool levelLoaderReady(levelLoader l, int level){
+  return true;
+}
+
+mapData levelLoaderTake(levelLoader l, int level){
+  l->wanted = 0;
+  return mapCreate(l->biome_data, l->pathDirt, level, mapLevelSeed(l->worldSeed, level));
+}
+
+void levelLoaderFree(levelLoader l){
+  free(l);
+}
+
+#endif
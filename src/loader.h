@@ -0,0 +1,24 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdbool.h>
+
+#include "raylib.h"
+#include "map.h"
+
+// Generates levels on a background thread so a transition only has to
+// swap the finished mapData in. Web builds have no threads, there the
+// level is generated synchronously when it is taken.
+typedef struct levelLoader *levelLoader;
+
+// Level n is always built from mapLevelSeed(worldSeed, n).
+extern levelLoader levelLoaderCreate(BIOME_DATA biome_data, Texture2D pathDirt, uint64_t worldSeed);
+// Start generating `level` unless it is already built or being built.
+extern void levelLoaderRequest(levelLoader l, int level);
+// True when levelLoaderTake(l, level) will not stall the frame.
+extern bool levelLoaderReady(levelLoader l, int level);
+// Hand the finished level over to the caller, waiting for it if needed.
+extern mapData levelLoaderTake(levelLoader l, int level);
+extern void levelLoaderFree(levelLoader l);
+
+#endif
@@ -5,6 +5,7 @@
 #include <assert.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
 
 #include "hash.h"
 #include "dynarray.h"
@@ -15,19 +16,43 @@
 #include "projectile.h"
 #include "impact.h"
 #include "utils.h"
+#include "assets.h"
+#include "music.h"
+#include "sfx.h"
 #include "gun.h"
 #include "computer.h"
 #include "npc.h"
 #include "coin.h"
+#include "loader.h"
+#include "jobs.h"
+#include "replay.h"
+#include "lighting.h"
+#include "spatial.h"
+#include "cellgrid.h"
+#include "flock.h"
+#include "birddraw.h"
 #include <time.h>
 // #include <math.h>
 
+#if defined(PLATFORM_ANDROID)
+#include <android_native_app_glue.h>
+// Defined by raylib's Android backend
+extern struct android_app *GetAndroidApp(void);
+#endif
+
 #define MAX_BOIDS 40
 #define SCREEN_WIDTH 400 
 #define SCREEN_HEIGHT 225 
 
 #define GRID_SIZE 20
 
+// Current level, rewritten on every transition and hack so a killed
+// process resumes where it left off
+#define LEVEL_SAVE_FILE "level.sav"
+
+#define MUZZLE_FLASH_TIME 0.06f
+#define MUZZLE_FLASH_RADIUS 80.0f
+
 #define MAX_FORCE 0.2
 #define MAX_SPEED 3
 
@@ -56,11 +81,8 @@ typedef enum {
 
 struct boid{
     Vector2 pos; 
-    int cellX;
-    int cellY;
     Vector2 velocity; 
     Vector2 acceleration; 
-    bool broken; 
     float moveTimer;
     bool isMoving; 
     
@@ -301,15 +323,9 @@ float randRange(float min, float max) {
 }
 
 
-void updateForEachBoid(hashkey k, hashvalue v, void * arg){
-    char *key = (char *) k; 
-    dynarray arr = (dynarray) v; 
-    dynarray toChange = (dynarray) arg; 
-    for (int i = 0; i < arr->len; i++){
-        boid b = arr->data[i];
-        
-        // b->acceleration.x = averageVels[i].x;
-        // b->acceleration.y = averageVels[i].y;
+void updateBoids(dynarray allBirds){
+    for (int i = 0; i < allBirds->len; i++){
+        boid b = allBirds->data[i];
 
         Vector2 offvel = Vector2Add(b->velocity, b->acceleration);
         b->velocity.x = offvel.x;
@@ -324,73 +340,7 @@ void updateForEachBoid(hashkey k, hashvalue v, void * arg){
         Vector2 off = Vector2Add(b->pos, b->velocity);
         b->pos.x = off.x;
         b->pos.y = off.y;
-
-        int newCX = ((int) b->pos.x) / GRID_SIZE;
-        int newCY = ((int) b->pos.y) / GRID_SIZE;
-
-        if (newCX != b->cellX || newCY != b->cellY){
-            // Need to update 
-            b->broken = true;
-            add_dynarray(toChange, strdup(key));
-        }
-
-    }
-}
-
-void printToChange(FILE *out, DA_ELEMENT el, int n){
-    char *arg = (char *) el; 
-    fprintf(out, "key : %s", arg);
-}
-
-void freeToChange(DA_ELEMENT el){
-    char *arg = (char *) el; 
-    free(arg);
-}
-
-void updateBoids(hash flockGrid, Vector2 *averageVels){
-    dynarray toChange = create_dynarray(&freeToChange, &printToChange);
-    hashForeach(flockGrid, &updateForEachBoid, toChange);
-
-    for (int i = 0; i < toChange->len; i++){
-        char *key = toChange->data[i];
-        dynarray arr = hashFind(flockGrid, key);
-
-        int j = 0;
-        while (j < arr->len){
-            boid old = arr->data[j];
-            if (!old->broken){
-                j += 1;
-                continue; 
-            }
-            // delete the boid from the list
-            remove_dynarray(arr, j);
-            // update the boid 
-            int newCX = ((int) old->pos.x) / GRID_SIZE;
-            int newCY = ((int) old->pos.y) / GRID_SIZE;
-            old->cellX = newCX;
-            old->cellY = newCY;
-            old->broken = false;
-
-            // insert the new boid into the hashmap
-            char buffer[25]; 
-            
-            dynarray array;
-
-            sprintf(buffer, "%d:%d", old->cellX, old->cellY);
-            if ( (array = hashFind(flockGrid, buffer)) != NULL){
-                // Then append it to the list 
-                add_dynarray(array, old);
-            }
-            else{
-                array = create_dynarray(NULL, NULL);
-                add_dynarray(array, old);
-                hashSet(flockGrid, buffer, array);
-            }
-
-        }
     }
-
-    free_dynarray(toChange);
 }
 
 Vector2 ClampMagnitude(Vector2 v, float maxLength) {
@@ -403,7 +353,12 @@ Vector2 ClampMagnitude(Vector2 v, float maxLength) {
 
 struct steeringData{
     Vector2 playerPos; 
-    hash flockGrid;
+    cellGrid grid;              // flying birds, bucketed by GRID_SIZE cells
+    boid *gathered;             // flying birds in allBirds order
+    Vector2 *gatheredPos;
+    boid *birds;                // the same birds in grid slot order
+    flockBirds kin;             // and their kinematics, for the neighbour kernel
+    int cap;
 };
 typedef struct steeringData *steeringData; 
 
@@ -411,52 +366,69 @@ typedef struct steeringData *steeringData;
 #define COHESION_WEIGHT 1.0f
 #define SEPARATION_WEIGHT 1.45f
 
-void calculateSteeringForEach(hashkey k, hashvalue v, void *arg) {
-    dynarray arr = (dynarray)v; 
-    steeringData data = (steeringData)arg; 
-    if (arr->len == 0) return; 
-    
-    char buffer[25];
+// Gathers the flying birds into grid slot order for steerBirds and
+// returns how many there are
+int gatherSteering(dynarray allBirds, steeringData data) {
+    if (allBirds->len > data->cap) {
+        data->cap = allBirds->len;
+        data->gathered = realloc(data->gathered, data->cap * sizeof(boid));
+        data->gatheredPos = realloc(data->gatheredPos, data->cap * sizeof(Vector2));
+        data->birds = realloc(data->birds, data->cap * sizeof(boid));
+        assert(data->gathered && data->gatheredPos && data->birds);
+        flockReserve(&data->kin, data->cap);
+    }
 
-    for (int i = 0; i < arr->len; i++) {
-        boid boi = arr->data[i];
+    int n = 0;
+    for (int i = 0; i < allBirds->len; i++) {
+        boid b = allBirds->data[i];
 
-        // Idle birds do not steer or move
-        if (boi->state == BIRD_IDLE) {
-            boi->velocity = (Vector2){0, 0};
-            boi->acceleration = (Vector2){0, 0};
+        // Idle birds do not steer or move, and only flying birds flock
+        if (b->state == BIRD_IDLE) {
+            b->velocity = (Vector2){0, 0};
+            b->acceleration = (Vector2){0, 0};
             continue;
         }
+        data->gathered[n] = b;
+        data->gatheredPos[n] = b->pos;
+        n++;
+    }
 
-        Vector2 avgVel = {0, 0}, avgPos = {0, 0}, avgSep = {0, 0};
-        int total = 0;
-
-        for (int x = boi->cellX - 1; x <= boi->cellX + 1; x++) {
-            for (int y = boi->cellY - 1; y <= boi->cellY + 1; y++) {
-                sprintf(buffer, "%d:%d", x, y);
-                dynarray array = hashFind(data->flockGrid, buffer);
-                if (!array) continue;
-
-                for (int z = 0; z < array->len; z++) {
-                    if (x == boi->cellX && y == boi->cellY && z == i) continue; 
-                    boid b = array->data[z];
-
-                    // Only flock with active (flying/departing) birds
-                    if (b->state == BIRD_IDLE) continue;
-
-                    total++;
-                    avgVel = Vector2Add(avgVel, b->velocity);
-                    avgPos = Vector2Add(avgPos, b->pos);
+    cellGrid grid = data->grid;
+    cellGridBuild(grid, data->gatheredPos, n);
+    flockBirds *kin = &data->kin;
+    kin->cellX = grid->slotX;
+    kin->cellY = grid->slotY;
+    for (int k = 0; k < n; k++) {
+        boid b = data->gathered[grid->items[k]];
+        data->birds[k] = b;
+        kin->px[k] = b->pos.x;
+        kin->py[k] = b->pos.y;
+        kin->vx[k] = b->velocity.x;
+        kin->vy[k] = b->velocity.y;
+    }
+    return n;
+}
 
-                    float d = Vector2Distance(boi->pos, b->pos);
-                    if (d > 0.001f) {
-                        Vector2 diff = Vector2Subtract(boi->pos, b->pos);
-                        diff = Vector2Scale(diff, 1.0f / (d * d));
-                        avgSep = Vector2Add(avgSep, diff);
-                    }
-                }
+// Steering for the gathered birds [begin, end); each bird only writes its
+// own acceleration, so ranges can run on any thread
+void steerBirds(void *ctx, int begin, int end) {
+    steeringData data = ctx;
+    cellGrid grid = data->grid;
+    const flockBirds *kin = &data->kin;
+    for (int i = begin; i < end; i++) {
+        boid boi = data->birds[i];
+
+        flockSums sums = {0};
+        for (int x = grid->slotX[i] - 1; x <= grid->slotX[i] + 1; x++) {
+            for (int y = grid->slotY[i] - 1; y <= grid->slotY[i] + 1; y++) {
+                int bucket = cellGridBucket(grid, x, y);
+                flockAccumulate(kin, grid->start[bucket], grid->start[bucket + 1], x, y, i, &sums);
             }
         }
+        Vector2 avgVel = { sums.velX, sums.velY };
+        Vector2 avgPos = { sums.posX, sums.posY };
+        Vector2 avgSep = { sums.sepX, sums.sepY };
+        int total = sums.count;
 
         Vector2 steering = {0, 0};
         if (total > 0) {
@@ -511,17 +483,46 @@ void calculateSteeringForEach(hashkey k, hashvalue v, void *arg) {
     }
 }
 
+// What the intent jobs of a frame work on
+struct intentsData{
+    enemyStore store;
+    const enemyHandle *sensing;     // the enemies scheduled to sense
+    npcGroup *npcs;
+    entity player;
+    tilemap map;
+    bool isHacking;
+};
 
+void senseEnemies(void *ctx, int begin, int end) {
+    struct intentsData *d = ctx;
+    for (int i = begin; i < end; i++)
+        enemySense(enemyGet(d->store, d->sensing[i]), d->player, d->map, d->isHacking);
+}
 
-
-void calculateSteering(hash flock ,steeringData data) {
-    hashForeach(flock, &calculateSteeringForEach, data);
+void moveNpcs(void *ctx, int begin, int end) {
+    struct intentsData *d = ctx;
+    for (int i = begin; i < end; i++)
+        npcMove(&d->npcs->hot[i], d->map);
 }
 
-void drawForEachBoid(hashkey k, hashvalue v, void * arg){
-    dynarray arr = (dynarray) v; 
-    for (int i = 0; i < arr->len; i++){
-        boid b = arr->data[i];
+void DrawBoids(dynarray allBirds){
+    if (birdDrawAvailable()) {
+        birdInstance *inst = birdDrawReserve(allBirds->len);
+        for (int i = 0; i < allBirds->len; i++) {
+            boid b = allBirds->data[i];
+            Vector2 dir = {1, 0};
+            if (Vector2Length(b->velocity) > 0.001f) {
+                dir = Vector2Normalize(b->velocity);
+            }
+            inst[i] = (birdInstance){ b->pos, dir, b->flapTimer, (float)b->state, b->facingRight, 0.0f };
+        }
+        birdDrawInstances(allBirds->len);
+        return;
+    }
+
+    // No instancing: the same shapes, one bird at a time
+    for (int i = 0; i < allBirds->len; i++){
+        boid b = allBirds->data[i];
         
         if (b->state == BIRD_IDLE) {
             // Draw a cute standing bird
@@ -587,10 +588,6 @@ void drawForEachBoid(hashkey k, hashvalue v, void * arg){
     }
 }
 
-void DrawBoids(hash flockGrid){
-    hashForeach(flockGrid, &drawForEachBoid, NULL);
-}
-
 float randFloat(float min, float max) {
     return min + ((float)rand() / (float)RAND_MAX) * (max - min);
 }
@@ -602,57 +599,30 @@ Vector2 randomVelocity(float minSpeed, float maxSpeed) {
     return (Vector2){ cosf(angle) * speed, sinf(angle) * speed };
 }
 
-void collectDirtTiles(hashkey k, hashvalue v, void *arg) {
-    rect r = (rect)v;
-    dynarray list = (dynarray)arg;
-    if (r && r->tile == DIRT) {
-        Vector2 *pos = malloc(sizeof(Vector2));
-        if (pos) {
-            *pos = (Vector2){ r->rectange.x + TILE_SIZE / 2.0f, r->rectange.y + TILE_SIZE / 2.0f };
-            add_dynarray(list, pos);
-        }
-    }
-}
-
-dynarray GetWalkableTiles(hash map) {
-    dynarray list = create_dynarray(&free, NULL);
-    hashForeach(map, &collectDirtTiles, list);
-    return list;
-}
-
-void InitBirds(hash map, hash flockGrid, dynarray allBirds, dynarray *walkableTilesOut) {
-    if (*walkableTilesOut) {
-        free_dynarray(*walkableTilesOut);
-    }
-    *walkableTilesOut = GetWalkableTiles(map);
-    dynarray walkableTiles = *walkableTilesOut;
-
+// Boids live in the level arena, allBirds only holds pointers.
+void InitBirds(mapData mData, dynarray allBirds) {
     int numClusters = 10;
     int birdsPerCluster = MAX_BOIDS / numClusters;
     for (int c = 0; c < numClusters; c++) {
         Vector2 centerPos = {0, 0};
-        if (walkableTiles && walkableTiles->len > 0) {
-            int idx = GetRandomValue(0, walkableTiles->len - 1);
-            centerPos = *(Vector2*)walkableTiles->data[idx];
+        if (mData.walkableCount > 0) {
+            int idx = GetRandomValue(0, mData.walkableCount - 1);
+            centerPos = mapWalkableTileCenter(mData, idx);
         } else {
             centerPos = (Vector2){GetRandomValue(0, SCREEN_WIDTH), GetRandomValue(0, SCREEN_HEIGHT)};
         }
 
         for (int j = 0; j < birdsPerCluster; j++) {
-            boid b = malloc(sizeof(struct boid));
-            assert(b != NULL);
+            boid b = arenaAlloc(mData.level, sizeof(struct boid));
 
             b->pos = (Vector2){
                 centerPos.x + randFloat(-30.0f, 30.0f),
                 centerPos.y + randFloat(-30.0f, 30.0f)
             };
-            b->cellX = (int)b->pos.x / GRID_SIZE;
-            b->cellY = (int)b->pos.y / GRID_SIZE;
             b->velocity = (Vector2){0, 0};
             b->acceleration = (Vector2){0, 0};
             b->isMoving = false;
             b->moveTimer = 0.0f;
-            b->broken = false;
 
             b->state = BIRD_IDLE;
             b->stateTimer = 0.0f;
@@ -662,68 +632,105 @@ void InitBirds(hash map, hash flockGrid, dynarray allBirds, dynarray *walkableTi
             b->startPos = b->pos;
 
             add_dynarray(allBirds, b);
+        }
+    }
+}
 
-            char buffer[25];
-            dynarray arr;
-            sprintf(buffer, "%d:%d", b->cellX, b->cellY);
-            if ((arr = hashFind(flockGrid, buffer)) != NULL) {
-                add_dynarray(arr, b);
-            } else {
-                arr = create_dynarray(NULL, NULL);
-                add_dynarray(arr, b);
-                hashSet(flockGrid, buffer, arr);
+#define PLAYER_STARTLE_RADIUS 50.0f
+#define BIRD_STARTLE_RADIUS 40.0f
+
+// Scratch for UpdateBirdsState, kept between ticks
+struct startleData{
+    cellGrid rooms;             // every bird, bucketed by room
+    cellGrid idle;              // idle birds near the player, by BIRD_STARTLE_RADIUS cells
+    Vector2 *pos;               // positions handed to the grid builds
+    boid *nearby;               // birds near the player's room this tick
+    boid *idleBirds;            // point i of the idle grid
+    boid *frontier;             // flying birds whose startle still has to spread
+    int cap;
+};
+typedef struct startleData *startleData;
+
+static void startleBird(boid b) {
+    b->state = BIRD_FLYING;
+    b->stateTimer = randFloat(2.5f, 4.0f);
+    b->velocity = (Vector2){ randFloat(-1.5f, 1.5f), randFloat(-3.0f, -1.0f) };
+    b->circleTarget = (Vector2){ b->startPos.x + randFloat(-80.0f, 80.0f), b->startPos.y + randFloat(-80.0f, 80.0f) };
+}
+
+// Startle the idle birds within `radius` of `from` and queue them on the
+// frontier so they pass the startle on in turn
+static void startleAround(startleData sd, int *frontierLen, Vector2 from, float radius) {
+    cellGrid grid = sd->idle;
+    if (grid->count == 0) return;
+    int x0 = cellGridCellOf(grid, from.x - radius), x1 = cellGridCellOf(grid, from.x + radius);
+    int y0 = cellGridCellOf(grid, from.y - radius), y1 = cellGridCellOf(grid, from.y + radius);
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            int bucket = cellGridBucket(grid, x, y);
+            for (int z = grid->start[bucket]; z < grid->start[bucket + 1]; z++) {
+                if (grid->slotX[z] != x || grid->slotY[z] != y) continue;
+                boid b = sd->idleBirds[grid->items[z]];
+                if (b->state != BIRD_IDLE || Vector2Distance(b->pos, from) >= radius) continue;
+                startleBird(b);
+                sd->frontier[(*frontierLen)++] = b;
             }
         }
     }
 }
 
-void UpdateBirdsState(dynarray allBirds, entity player, dynarray walkableTiles, float dt) {
+void UpdateBirdsState(dynarray allBirds, entity player, mapData mData, startleData sd, float dt) {
     if (!allBirds) return;
 
     int roomX = player->pos.x / ROOM_SIZE;
     int roomY = player->pos.y / ROOM_SIZE;
 
-    // 1) Startle idle birds close to player (radius reduced from 90 to 50)
-    for (int i = 0; i < allBirds->len; i++) {
-        boid b = (boid)allBirds->data[i];
-        if (!IsBirdInCurrentGrid(b, roomX, roomY)) continue;
-        if (b->state == BIRD_IDLE) {
-            float dist = Vector2Distance(b->pos, player->pos);
-            if (dist < 50.0f) {
-                b->state = BIRD_FLYING;
-                b->stateTimer = randFloat(2.5f, 4.0f);
-                b->velocity = (Vector2){ randFloat(-1.5f, 1.5f), randFloat(-3.0f, -1.0f) };
-                b->circleTarget = (Vector2){ b->startPos.x + randFloat(-80.0f, 80.0f), b->startPos.y + randFloat(-80.0f, 80.0f) };
-            }
-        }
+    if (allBirds->len > sd->cap) {
+        sd->cap = allBirds->len;
+        sd->pos = realloc(sd->pos, sd->cap * sizeof(Vector2));
+        sd->nearby = realloc(sd->nearby, sd->cap * sizeof(boid));
+        sd->idleBirds = realloc(sd->idleBirds, sd->cap * sizeof(boid));
+        sd->frontier = realloc(sd->frontier, sd->cap * sizeof(boid));
+        assert(sd->pos && sd->nearby && sd->idleBirds && sd->frontier);
     }
 
-    // 2) Startle neighbor chain reaction (radius reduced from 60 to 40)
-    for (int i = 0; i < allBirds->len; i++) {
-        boid b = (boid)allBirds->data[i];
-        if (!IsBirdInCurrentGrid(b, roomX, roomY)) continue;
-        if (b->state == BIRD_IDLE) {
-            for (int j = 0; j < allBirds->len; j++) {
-                if (i == j) continue;
-                boid other = (boid)allBirds->data[j];
-                if (other->state == BIRD_FLYING) {
-                    float dist = Vector2Distance(b->pos, other->pos);
-                    if (dist < 40.0f) {
-                        b->state = BIRD_FLYING;
-                        b->stateTimer = randFloat(2.5f, 4.0f);
-                        b->velocity = (Vector2){ randFloat(-1.5f, 1.5f), randFloat(-3.0f, -1.0f) };
-                        b->circleTarget = (Vector2){ b->startPos.x + randFloat(-80.0f, 80.0f), b->startPos.y + randFloat(-80.0f, 80.0f) };
-                        break;
-                    }
+    // Per-room lists: one counting sort of every bird by room, then only the
+    // rooms around the player are looked at. Flying birds there are the
+    // startle sources, birds within the room margin are the ones updated.
+    for (int i = 0; i < allBirds->len; i++) sd->pos[i] = ((boid)allBirds->data[i])->pos;
+    cellGridBuild(sd->rooms, sd->pos, allBirds->len);
+    int nearbyLen = 0, idleLen = 0, frontierLen = 0;
+    for (int ry = roomY - 1; ry <= roomY + 1; ry++) {
+        for (int rx = roomX - 1; rx <= roomX + 1; rx++) {
+            int bucket = cellGridBucket(sd->rooms, rx, ry);
+            for (int z = sd->rooms->start[bucket]; z < sd->rooms->start[bucket + 1]; z++) {
+                if (sd->rooms->slotX[z] != rx || sd->rooms->slotY[z] != ry) continue;
+                boid b = allBirds->data[sd->rooms->items[z]];
+                if (b->state == BIRD_FLYING) sd->frontier[frontierLen++] = b;
+                if (!IsBirdInCurrentGrid(b, roomX, roomY)) continue;
+                sd->nearby[nearbyLen++] = b;
+                if (b->state == BIRD_IDLE) {
+                    sd->pos[idleLen] = b->pos;
+                    sd->idleBirds[idleLen++] = b;
                 }
             }
         }
     }
+    cellGridBuild(sd->idle, sd->pos, idleLen);
+
+    // 1) Startle idle birds close to player (radius reduced from 90 to 50)
+    startleAround(sd, &frontierLen, player->pos, PLAYER_STARTLE_RADIUS);
+
+    // 2) Startle neighbor chain reaction (radius reduced from 60 to 40), as a
+    // wavefront: every flying bird startles the idle birds in the cells
+    // around it, and those join the frontier until it runs dry
+    for (int head = 0; head < frontierLen; head++) {
+        startleAround(sd, &frontierLen, sd->frontier[head]->pos, BIRD_STARTLE_RADIUS);
+    }
 
     // 3) Update timers, flapping, and fly away / reset transitions
-    for (int i = 0; i < allBirds->len; i++) {
-        boid b = (boid)allBirds->data[i];
-        if (!IsBirdInCurrentGrid(b, roomX, roomY)) continue;
+    for (int i = 0; i < nearbyLen; i++) {
+        boid b = sd->nearby[i];
         b->flapTimer += dt;
 
         if (b->state == BIRD_IDLE) {
@@ -750,12 +757,11 @@ void UpdateBirdsState(dynarray allBirds, entity player, dynarray walkableTiles,
             b->stateTimer -= dt;
             float distToPlayer = Vector2Distance(b->pos, player->pos);
             if (b->stateTimer <= 0.0f || distToPlayer > 500.0f) {
-                if (walkableTiles && walkableTiles->len > 0) {
+                if (mData.walkableCount > 0) {
                     Vector2 picked = {0, 0};
                     for (int attempt = 0; attempt < 10; attempt++) {
-                        int idx = GetRandomValue(0, walkableTiles->len - 1);
-                        Vector2 *targetPos = walkableTiles->data[idx];
-                        picked = *targetPos;
+                        int idx = GetRandomValue(0, mData.walkableCount - 1);
+                        picked = mapWalkableTileCenter(mData, idx);
                         if (Vector2Distance(picked, player->pos) > 400.0f) {
                             break;
                         }
@@ -796,7 +802,7 @@ static void FindClosestUnhackedComputerCb(hashkey k, hashvalue v, void *arg) {
     }
 }
 
-static Vector2 FindClosestExitTile(hash map, int currentCx, int currentCy, Vector2 targetPos) {
+static Vector2 FindClosestExitTile(tilemap map, int currentCx, int currentCy, Vector2 targetPos) {
     int minTileX = currentCx * CHUNK_SIZE;
     int maxTileX = (currentCx + 1) * CHUNK_SIZE - 1;
     int minTileY = currentCy * CHUNK_SIZE;
@@ -804,12 +810,10 @@ static Vector2 FindClosestExitTile(hash map, int currentCx, int currentCy, Vecto
     
     Vector2 bestExit = targetPos;
     float minDist = 99999999.0f;
-    char key[32];
     
     // Check top boundary
     for (int tx = minTileX; tx <= maxTileX; tx++) {
-        sprintf(key, "%d:%d", tx, minTileY);
-        rect r = hashFind(map, key);
+        rect r = mapGetRecAt(map, tx, minTileY);
         if (r && r->tile == DIRT) {
             Vector2 tileWorldPos = { tx * TILE_SIZE + TILE_SIZE / 2.0f, minTileY * TILE_SIZE + TILE_SIZE / 2.0f };
             float dist = Vector2Distance(tileWorldPos, targetPos);
@@ -821,8 +825,7 @@ static Vector2 FindClosestExitTile(hash map, int currentCx, int currentCy, Vecto
     }
     // Check bottom boundary
     for (int tx = minTileX; tx <= maxTileX; tx++) {
-        sprintf(key, "%d:%d", tx, maxTileY);
-        rect r = hashFind(map, key);
+        rect r = mapGetRecAt(map, tx, maxTileY);
         if (r && r->tile == DIRT) {
             Vector2 tileWorldPos = { tx * TILE_SIZE + TILE_SIZE / 2.0f, maxTileY * TILE_SIZE + TILE_SIZE / 2.0f };
             float dist = Vector2Distance(tileWorldPos, targetPos);
@@ -834,8 +837,7 @@ static Vector2 FindClosestExitTile(hash map, int currentCx, int currentCy, Vecto
     }
     // Check left boundary
     for (int ty = minTileY; ty <= maxTileY; ty++) {
-        sprintf(key, "%d:%d", minTileX, ty);
-        rect r = hashFind(map, key);
+        rect r = mapGetRecAt(map, minTileX, ty);
         if (r && r->tile == DIRT) {
             Vector2 tileWorldPos = { minTileX * TILE_SIZE + TILE_SIZE / 2.0f, ty * TILE_SIZE + TILE_SIZE / 2.0f };
             float dist = Vector2Distance(tileWorldPos, targetPos);
@@ -847,8 +849,7 @@ static Vector2 FindClosestExitTile(hash map, int currentCx, int currentCy, Vecto
     }
     // Check right boundary
     for (int ty = minTileY; ty <= maxTileY; ty++) {
-        sprintf(key, "%d:%d", maxTileX, ty);
-        rect r = hashFind(map, key);
+        rect r = mapGetRecAt(map, maxTileX, ty);
         if (r && r->tile == DIRT) {
             Vector2 tileWorldPos = { maxTileX * TILE_SIZE + TILE_SIZE / 2.0f, ty * TILE_SIZE + TILE_SIZE / 2.0f };
             float dist = Vector2Distance(tileWorldPos, targetPos);
@@ -862,7 +863,7 @@ static Vector2 FindClosestExitTile(hash map, int currentCx, int currentCy, Vecto
     return bestExit;
 }
 
-static void DrawOrbitingArrow(hash computers, hash map, entity player, Texture2D computerTex) {
+static void DrawOrbitingArrow(hash computers, tilemap map, entity player, Texture2D computerTex) {
     if (!player) return;
     Vector2 playerCenter = (Vector2){ player->rect.x + player->rect.width / 2.0f, player->rect.y + player->rect.height / 2.0f };
     
@@ -951,12 +952,6 @@ typedef enum{
     P_RUN,
 } PlayerState; 
 
-// free offgrids 
-void offgridsFree(hashvalue val){
-    dynarray o = (dynarray) val; 
-    free_dynarray(o);
-}
-
 typedef struct { 
     Texture2D tex; 
     bool weapon; 
@@ -1208,26 +1203,112 @@ typedef enum {
         TT_DEATH
 } TransitionType;
 
+// Android starts the game in "/", which is read only, so the save goes
+// to the app's internal storage there
+static const char *levelSavePath(void) {
+#if defined(PLATFORM_ANDROID)
+    static char path[512];
+    if (path[0] == '\0')
+        snprintf(path, sizeof(path), "%s/%s", GetAndroidApp()->activity->internalDataPath, LEVEL_SAVE_FILE);
+    return path;
+#else
+    return LEVEL_SAVE_FILE;
+#endif
+}
+
 static inline float clampf(float v, float lo, float hi) {
     return v < lo ? lo : (v > hi ? hi : v);
 }
 
 
-int main() {
+int main(int argc, char **argv) {
     InitWindow(SCREEN_WIDTH * 2, SCREEN_HEIGHT * 2, "Vampy Reloaded (x2 scaled)");
     InitAudioDevice();
+    musicInit();
+    sfxInit();
     SetTargetFPS(60);
 
     // -------- Splash / Menu / Game States --------
     typedef enum { GS_SPLASH, GS_MENU, GS_GAME } GameState;
     GameState gState = GS_SPLASH;
     float splashTimer = 0.0f;
-    const float SPLASH_DURATION = 4.0f;
+    const float SPLASH_DURATION = 2.0f;
 
-    // Load assets needed for splash/menu
-    loadDirectory();
-    Texture2D logo = LoadTexture("misc/pfp.png");
-    closeDirectory();
+    // Everything but the logo is decoded in the background while the
+    // splash and menu run, the menu's own frames first so they are ready
+    // soonest. Nothing may ChangeDirectory until the loader is freed.
+    assetLoader assets = assetsCreate();
+    Texture2D logo = assetsTextureNow(assets, "misc/pfp.png");
+    Animation home_no_loop_animation = assetsAnimation(assets, "entities/home_no_loop/", 4);
+    Animation home_animation = assetsAnimation(assets, "entities/home/", 2);
+    int menuAssets = assetsQueued(assets);
+
+    Animation PlayerAnimations[] = {
+        assetsAnimation(assets, "entities/player/idle/", 4),
+        assetsAnimation(assets, "entities/player/run/", 4),
+        assetsAnimation(assets, "entities/player/hack/", 4),
+    };
+    Animation EnemyAnimations[] = {
+        assetsAnimation(assets, "entities/enemy/idle/", 4),
+        assetsAnimation(assets, "entities/enemy/run/", 4),
+    };
+
+    Animation CowAnimations[] = {
+        assetsAnimation(assets, "entities/npcs/cow/idle/", 4),
+        assetsAnimation(assets, "entities/npcs/cow/run/", 4),
+    };
+
+    Animation CitizenAnimations[] = {
+        assetsAnimation(assets, "entities/npcs/citizen/idle/", 4),
+        assetsAnimation(assets, "entities/npcs/citizen/run/", 4),
+    };
+
+    Animation *NPCAnimations[] = {
+        CitizenAnimations,
+        CowAnimations,
+    };
+
+    int NO_OF_BIOMES = 3; 
+    int NO_OF_FOREST_TEXS = 2;
+    int NO_OF_TOWN_TEXS = 9;
+    int NO_OF_VILLAGE_TEXS = 14;
+    Texture2D *forestTexs = assetsTextures(assets, "tiles/offgrid/forest/", NO_OF_FOREST_TEXS);
+    Texture2D *townTexs = assetsTextures(assets, "tiles/offgrid/town/", NO_OF_TOWN_TEXS);
+    Texture2D *villageTexs = assetsTextures(assets, "tiles/offgrid/village/", NO_OF_VILLAGE_TEXS);
+    Texture2D *gunTexs = assetsTextures(assets, "entities/guns/", 6);
+
+    // Texture2D gunTex = LoadTexture("entities/enemy/gun.png");
+    Texture2D tiles[2];
+    assetsTexture(assets, "tiles/dirt.png", &tiles[0]);
+    assetsTexture(assets, "tiles/stone.png", &tiles[1]);
+    // Tile Types 
+    // [bottom_left, bottom_right, bottom, left, middle, right, top_left, top_right, top, bottom-left-1, bottom-right-1, bottom-1]
+    Texture2D stoneTiles[12];
+    assetsTexture(assets, "tiles/stone2/bottom-left.png", &stoneTiles[0]);
+    assetsTexture(assets, "tiles/stone2/bottom-right.png", &stoneTiles[1]);
+    assetsTexture(assets, "tiles/stone2/bottom.png", &stoneTiles[2]);
+    assetsTexture(assets, "tiles/stone2/left.png", &stoneTiles[3]);
+    assetsTexture(assets, "tiles/stone2/middle.png", &stoneTiles[4]);
+    assetsTexture(assets, "tiles/stone2/right.png", &stoneTiles[5]);
+    assetsTexture(assets, "tiles/stone2/top-left.png", &stoneTiles[6]);
+    assetsTexture(assets, "tiles/stone2/top-right.png", &stoneTiles[7]);
+    assetsTexture(assets, "tiles/stone2/top.png", &stoneTiles[8]);
+    assetsTexture(assets, "tiles/stone2/bottom-left-1.png", &stoneTiles[9]);
+    assetsTexture(assets, "tiles/stone2/bottom-right-1.png", &stoneTiles[10]);
+    assetsTexture(assets, "tiles/stone2/bottom-1.png", &stoneTiles[11]);
+
+    Texture2D *dirtTiles = assetsTextures(assets, "tiles/dirt2/", 4);
+
+    Texture2D pathDirt, enemyGunTex, computerTex, heartTex, medkitTex;
+    assetsTexture(assets, "tiles/dirt/1.png", &pathDirt);
+    assetsTexture(assets, "entities/enemy/pistol.png", &enemyGunTex);
+    assetsTexture(assets, "entities/computer/computer.png", &computerTex);
+    assetsTexture(assets, "entities/items/heart.png", &heartTex);
+    assetsTexture(assets, "entities/items/fab.png", &medkitTex);
+
+    Texture2D noise1, noise2;
+    assetsTexture(assets, "misc/pnoise.png", &noise1);
+    assetsTexture(assets, "misc/pnoise2.png", &noise2);
 
     float timer = 0;
     int currentFrame = 0;
@@ -1236,6 +1317,7 @@ int main() {
     while (!WindowShouldClose() && gState == GS_SPLASH) {
         float dt = GetFrameTime();
         splashTimer += dt;
+        assetsUpload(assets, 0.004);
 
         // Fade in first 0.6s, hold, fade out last 0.8s
         float fadeInTime = 0.6f;
@@ -1292,21 +1374,19 @@ int main() {
                          SCREEN_HEIGHT * 2 - 50,
                          18,
                          (Color){180,180,180,(unsigned char)(200 * alpha * hintA)});
+                DrawRectangle((SCREEN_WIDTH * 2 - 200) / 2, SCREEN_HEIGHT * 2 - 24,
+                              (int)(200 * assetsProgress(assets)), 3,
+                              (Color){180,180,180,(unsigned char)(200 * alpha * hintA)});
             }
         EndDrawing();
 
         if (splashTimer >= SPLASH_DURATION) gState = GS_MENU;
     }
-    if (WindowShouldClose()) { CloseWindow(); return 0; }
+    if (WindowShouldClose()) { assetsFree(assets); musicShutdown(); sfxUnload(); CloseAudioDevice(); CloseWindow(); return 0; }
 
 
-    loadDirectory();
-    Animation home_no_loop_animation = loadAnimation("entities/home_no_loop/", 4);
-    Animation home_animation = loadAnimation("entities/home/", 2);
-    Music home_bgm = LoadMusicStream("music/homebgm.wav");
-    closeDirectory();
-    home_bgm.looping = true;
-    PlayMusicStream(home_bgm);
+    assetsFinish(assets, menuAssets);
+    musicPlay("music/homebgm.qoa");
 
     int noLoopFrame = 0; 
     float noLoopTimer = 0.0f; 
@@ -1314,7 +1394,7 @@ int main() {
     // --- Main Menu Loop (Play Button) ---
     while (!WindowShouldClose() && gState == GS_MENU)
     {
-        UpdateMusicStream(home_bgm);
+        assetsUpload(assets, 0.004);
         BeginDrawing();
             ClearBackground((Color){ 15, 15, 25, 255 });
 
@@ -1415,51 +1495,21 @@ int main() {
 
     if (WindowShouldClose())
     {
+        assetsFree(assets);
+        musicShutdown();
+        sfxUnload();
+        CloseAudioDevice();
         CloseWindow();
         return 0;
     }
 
-    StopMusicStream(home_bgm);
-    UnloadMusicStream(home_bgm);
-
     // --- (Existing game asset loading & setup now runs AFTER menu) ---
     // 🎯 Offscreen render target at original resolution
     RenderTexture2D target = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
 
-    // Loading files 
-    Animation PlayerAnimations[] = {
-        loadAnimation("entities/player/idle/", 4),
-        loadAnimation("entities/player/run/", 4),
-        loadAnimation("entities/player/hack/", 4),
-    };
-    Animation EnemyAnimations[] = {
-        loadAnimation("entities/enemy/idle/", 4),
-        loadAnimation("entities/enemy/run/", 4),
-    };
-
-    Animation CowAnimations[] = {
-        loadAnimation("entities/npcs/cow/idle/", 4),
-        loadAnimation("entities/npcs/cow/run/", 4),
-    };
-
-    Animation CitizenAnimations[] = {
-        loadAnimation("entities/npcs/citizen/idle/", 4),
-        loadAnimation("entities/npcs/citizen/run/", 4),
-    };
-
-    Animation *NPCAnimations[] = {
-        CitizenAnimations,
-        CowAnimations,
-    };
-
-    int NO_OF_BIOMES = 3; 
-    int NO_OF_FOREST_TEXS = 2;
-    int NO_OF_TOWN_TEXS = 9;
-    int NO_OF_VILLAGE_TEXS = 14;
-    Texture2D *forestTexs = loadTexturesFromDirectory("tiles/offgrid/forest/", NO_OF_FOREST_TEXS);
-    Texture2D *townTexs = loadTexturesFromDirectory("tiles/offgrid/town/", NO_OF_TOWN_TEXS);
-    Texture2D *villageTexs = loadTexturesFromDirectory("tiles/offgrid/village/", NO_OF_VILLAGE_TEXS);
-    Texture2D *gunTexs = loadTexturesFromDirectory("entities/guns/", 6);
+    // Usually everything is on the GPU by now; otherwise wait for the rest
+    assetsFinish(assets, assetsQueued(assets));
+    assetsFree(assets);
 
     BIOME_DATA biome_data = malloc(sizeof(struct BIOME_DATA)); 
     biome_data->texs = malloc(sizeof(Texture2D *) * NO_OF_BIOMES);
@@ -1473,55 +1523,22 @@ int main() {
 
     // printf("%d", biome_data->texs[TOWN][0].height);
 
-    loadDirectory();
-    // Texture2D gunTex = LoadTexture("entities/enemy/gun.png");
-    Texture2D tiles[] = {
-        LoadTexture("tiles/dirt.png"),
-        LoadTexture("tiles/stone.png")
-    };
-    // Tile Types 
-    // [bottom_left, bottom_right, bottom, left, middle, right, top_left, top_right, top, bottom-left-1, bottom-right-1, bottom-1]
-    Texture2D stoneTiles[] = {
-        LoadTexture("tiles/stone2/bottom-left.png"),
-        LoadTexture("tiles/stone2/bottom-right.png"),
-        LoadTexture("tiles/stone2/bottom.png"),
-        LoadTexture("tiles/stone2/left.png"),
-        LoadTexture("tiles/stone2/middle.png"),
-        LoadTexture("tiles/stone2/right.png"),
-        LoadTexture("tiles/stone2/top-left.png"),
-        LoadTexture("tiles/stone2/top-right.png"),
-        LoadTexture("tiles/stone2/top.png"),
-        LoadTexture("tiles/stone2/bottom-left-1.png"),
-        LoadTexture("tiles/stone2/bottom-right-1.png"),
-        LoadTexture("tiles/stone2/bottom-1.png"),
-    };
-
-    Texture2D dirtTiles[] = {
-        LoadTexture("tiles/dirt2/1.png"),
-        LoadTexture("tiles/dirt2/2.png"),
-        LoadTexture("tiles/dirt2/3.png"),
-        LoadTexture("tiles/dirt2/4.png"),
-    };
-
-    Texture2D pathDirt = LoadTexture("tiles/dirt/1.png");
-    Texture2D enemyGunTex = LoadTexture("entities/enemy/pistol.png");
-    Texture2D computerTex = LoadTexture("entities/computer/computer.png");
-    Texture2D heartTex = LoadTexture("entities/items/heart.png");
-    closeDirectory();
-
     Joystick joy = CreateJoystick((Vector2){100, 350}, 60);
     Joystick aim = CreateJoystick((Vector2){700, 350}, 60);
 
-    hash flockGrid = hashCreate(NULL, &free_dynarray, NULL); 
-    dynarray allBirds = create_dynarray(&free, NULL);
-    dynarray walkableTiles = NULL;
+    dynarray allBirds = create_dynarray(NULL, NULL);
     entity player = entityCreate(400, 225, 15, 15);
     PlayerState pState = P_IDLE;
     int facingRight = 1; 
     Vector2 offset = {0, 0};
 
-    steeringData data = malloc(sizeof(struct steeringData));
-    data->flockGrid = flockGrid;
+    steeringData data = calloc(1, sizeof(struct steeringData));
+    assert(data != NULL);
+    data->grid = cellGridCreate(GRID_SIZE);
+    startleData startle = calloc(1, sizeof(struct startleData));
+    assert(startle != NULL);
+    startle->rooms = cellGridCreate(ROOM_SIZE);
+    startle->idle = cellGridCreate(BIRD_STARTLE_RADIUS);
     data->playerPos = player->pos;
 
     Camera2D camera = {0};
@@ -1532,27 +1549,53 @@ int main() {
 
     dynarray projectiles = create_dynarray(&projectileFree,NULL);
     dynarray eprojectiles = create_dynarray(&projectileFree, NULL);
+    spatialGrid broadphase = spatialCreate(SPATIAL_CELL_SIZE);
 
-    hash offgridMap = hashCreate(NULL, &offgridsFree, NULL);
     dynarray offgrids;
 
-    Vector2 averageVels[MAX_BOIDS];
     Vector2 swarmTarget = player->pos;
     Vector2 previousOffset = {0.0f, 0.0f};
 
-    mapData mData = mapCreate(offgridMap, biome_data, pathDirt, 1);
-    hash map = mData.map;
+    // Command line: [seed] [--record file | --replay file]. A seed replays
+    // the same run of levels, a replay also the same input; without either
+    // carry on from the saved level if there is one.
+    const char *seedArg = NULL, *recordPath = NULL, *replayPath = NULL;
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replayPath = argv[++i];
+        else seedArg = argv[i];
+    }
+    uint64_t worldSeed = seedArg ? strtoull(seedArg, NULL, 10) : (uint64_t)time(NULL);
+    uint32_t randomSeed = (uint32_t)time(NULL);
+    replay rep = NULL;
+    if (replayPath && (rep = replayPlay(replayPath)) != NULL){
+        worldSeed = replayWorldSeed(rep);
+        randomSeed = replayRandomSeed(rep);
+    }
+    else if (recordPath){
+        rep = replayRecord(recordPath, worldSeed, randomSeed);
+    }
+    SetRandomSeed(randomSeed);
+    srand(randomSeed);
 
-    player->pos = mapFindSpawnTopLeft(map);
-    InitBirds(map, flockGrid, allBirds, &walkableTiles);
+    int startLevel = 1;
+    mapData mData;
+    bool resumed = !seedArg && !rep && mapLoad(levelSavePath(), biome_data, pathDirt, &mData, &worldSeed, &startLevel);
+    TraceLog(LOG_INFO, "World seed: %llu%s", (unsigned long long)worldSeed, resumed ? " (resumed)" : "");
+    levelLoader loader = levelLoaderCreate(biome_data, pathDirt, worldSeed);
+    if (!resumed) mData = levelLoaderTake(loader, startLevel);
+    levelLoaderRequest(loader, startLevel + 1);
+    tilemap map = mData.map;
 
-    Enemy enemy = enemyCreate(50, 60, 15, 15);
+    player->pos = mData.spawn;
+    InitBirds(mData, allBirds);
 
     char enemyKey[22];
-    dynarray enemies; 
-    srand(time(NULL));
+    const enemyHandle *enemies;
+    int enemyCount;
 
     float shootCooldown = 0.0f; 
+    float muzzleFlash = 0.0f;
     float frameTime = 0.1f;
 
 
@@ -1562,23 +1605,18 @@ int main() {
     // Shader stuff
     loadDirectory();
     Shader shader = LoadShader(0, "shaders/atmosphere.fs");
+    lightingInit(SCREEN_WIDTH, SCREEN_HEIGHT);
+    birdDrawInit();
     closeDirectory();
     int timeLoc = GetShaderLocation(shader, "time");
     int itimeLoc = GetShaderLocation(shader, "itime");
     int darknessLoc = GetShaderLocation(shader, "darkness");
     int jekyllLoc = GetShaderLocation(shader, "jekyll");
     int camScrollLoc = GetShaderLocation(shader, "cam_scroll");
+    int lightmapLoc = GetShaderLocation(shader, "lightmap");
 
     // Music 
-    Music bgm = LoadMusicStream("music/bgm.wav");
-    bgm.looping = true;
-    PlayMusicStream(bgm);
-
-    // Bind Noise Texture
-    loadDirectory();
-    Texture2D noise1 = LoadTexture("misc/pnoise.png");
-    Texture2D noise2 = LoadTexture("misc/pnoise2.png");
-    closeDirectory();
+    musicPlay("music/bgm.qoa");
 
     // Then bind the textures
 
@@ -1616,6 +1654,7 @@ int main() {
     guns[0].texture = gunTexs[0];
     guns[0].damage = 100.0f;
     guns[0].speed = 16.0f;
+    guns[0].sound = SFX_SNIPER;
     guns[0].numberOfProjectiles = 1;
 
     // submachine gun 
@@ -1625,6 +1664,7 @@ int main() {
     guns[1].texture = gunTexs[1];
     guns[1].damage = 20.0f;
     guns[1].speed = 12.0f;
+    guns[1].sound = SFX_SMG;
     guns[1].numberOfProjectiles = 1;
     // Double uzi 
     guns[2].cooldown = 0.2f;
@@ -1633,6 +1673,7 @@ int main() {
     guns[2].texture = gunTexs[2];
     guns[2].damage = 8.0f;
     guns[2].speed = 13.0f;
+    guns[2].sound = SFX_UZI;
     guns[2].numberOfProjectiles = 2;
     // pistol 
     guns[3].cooldown = 40.0f / 60.0f;
@@ -1641,6 +1682,7 @@ int main() {
     guns[3].texture = gunTexs[3];
     guns[3].damage = 25.0f;
     guns[3].speed = 10.0f;
+    guns[3].sound = SFX_PISTOL;
     guns[3].numberOfProjectiles = 1;
     // Shotgun
     guns[4].cooldown = 1.0f;
@@ -1649,6 +1691,7 @@ int main() {
     guns[4].texture = gunTexs[4];
     guns[4].damage = 40.0f;
     guns[4].speed = 9.0f;
+    guns[4].sound = SFX_SHOTGUN;
     guns[4].numberOfProjectiles = 4;
     // Mini Gun
     guns[5].cooldown = 0.1f;
@@ -1657,10 +1700,10 @@ int main() {
     guns[5].texture = gunTexs[5];
     guns[5].damage = 16.0f;
     guns[5].speed = 15.0f;
+    guns[5].sound = SFX_MINIGUN;
     guns[5].numberOfProjectiles = 2;
 
 
-    loadDirectory();
     // Shop items 
     int totalShopItems = 7;
     ShopItem shopItems[totalShopItems];
@@ -1670,9 +1713,7 @@ int main() {
     shopItems[3] = (ShopItem){gunTexs[3], true, 25, "Pistol"};
     shopItems[4] = (ShopItem){gunTexs[4], true, 80, "Shotgun"};
     shopItems[5] = (ShopItem){gunTexs[5], true, 150, "Minigun"};
-    shopItems[6] = (ShopItem){LoadTexture("entities/items/fab.png"), false, 30, "Medkit"};
-
-    closeDirectory();
+    shopItems[6] = (ShopItem){medkitTex, false, 30, "Medkit"};
 
     Gun g = guns[3]; // start with random gun
     int ammo = g.maxAmmo;
@@ -1686,9 +1727,9 @@ int main() {
     Computer currComputer; 
     bool isHacking = false;
 
-    int computersHacked = 0;
+    int computersHacked = mapComputersHacked(mData);
 
-    int level = 1; 
+    int level = startLevel; 
 
     int maxHealth = 5;
     int health = maxHealth;
@@ -1703,18 +1744,19 @@ int main() {
     float notificationTimer = 0.0f;
 
     // NPCs
-    dynarray npcs; 
+    npcGroup *npcs; 
 
 
 
-    while (!WindowShouldClose()) {
-        UpdateMusicStream(bgm);
+    while (!WindowShouldClose() && !replayFinished(rep)) {
         double t_frame_start = GetTime();
 
         int roomX = player->pos.x / ROOM_SIZE;
         int roomY = player->pos.y / ROOM_SIZE;
+        mapStreamAround(map, roomX, roomY);
 
-        float delta = GetFrameTime();
+        float delta = replayBeginFrame(rep, GetFrameTime());
+        gameSetFrameTime(delta);
 
         double t_anim_start = GetTime();
         // Animation frame timer
@@ -1727,17 +1769,20 @@ int main() {
 
         double t_input_start = GetTime();
         if (isHacking && currComputer){
-            currComputer->amountLeftToHack -= GetFrameTime() * 5;
+            currComputer->amountLeftToHack -= delta * 5;
             if (currComputer->amountLeftToHack <= 0) {
                 currComputer->hacked = true;
                 computersHacked += 1;
                 isHacking = false;
                 printf("Computer hacked!\n");
+                // the last one saves with the next level instead
+                if (computersHacked < mData.noOfComputers && !replayPlaying(rep)) mapSave(levelSavePath(), mData, worldSeed, level);
             }
 
             if (computersHacked >= mData.noOfComputers){
                 // Move to next level 
                 level += 1;
+                levelLoaderRequest(loader, level);
                 transitionType = TT_LEVEL;
                 transitioning = true;
                 transitionPhaseLoad = false;       // we will first expand
@@ -1752,10 +1797,15 @@ int main() {
                 UpdateJoysticks(&joy, &aim);
             }
         }
+        bool shooting = aim.state == JOY_SHOOTING;
+        replaySticks(rep, &joy.value, &aim.value, &shooting);
+        if (shooting) aim.state = JOY_SHOOTING;
+        else if (aim.state == JOY_SHOOTING) aim.state = JOY_AIMING;
         double t_input_end = GetTime();
 
-        if (IsKeyPressed(KEY_J)){
+        if (replayButton(rep, REPLAY_NEXT_LEVEL, IsKeyPressed(KEY_J))){
             level += 1;
+            levelLoaderRequest(loader, level);
             transitioning = true;
             transitionRadius = 0.0f;
             transitionCenter = player->pos;
@@ -1836,7 +1886,9 @@ int main() {
             }
 
 
+            sfxPlay(g.sound, 1.0f, 0.0f);
             shootCooldown = g.cooldown;
+            muzzleFlash = MUZZLE_FLASH_TIME;
             ammo--; 
             offset.x -= (aim.value.x * 5); 
             offset.y -= (aim.value.y * 5);  
@@ -1871,10 +1923,7 @@ int main() {
         if (playerAlive){
             update(player, map, offset);
         }
-        UpdateBirdsState(allBirds, player, walkableTiles, delta);
-        data->playerPos = player->pos;
-        calculateSteering(flockGrid, data);
-        updateBoids(flockGrid, averageVels);
+        UpdateBirdsState(allBirds, player, mData, startle, delta);
 
         UpdateCameraRoom(&camera, player);
         Impact_UpdateShake(&camera, delta);
@@ -1885,33 +1934,34 @@ int main() {
         MapEnsureCache(map, camera, tiles, stoneTiles, dirtTiles);
 
         if (transitioning) {
-            float delta = GetFrameTime();
+            float delta = gameFrameTime();
 
             if (transitionType == TT_LEVEL) {
                 // LEVEL TRANSITION: phase 1 = expand circle until reaches max -> load -> shrink circle back to 0
                 if (!transitionPhaseLoad) {
                     // expanding
                     transitionRadius += transitionSpeed * delta;
-                    if (transitionRadius >= transitionMaxRadius) {
-                        // reached full screen: load next level
+                    // reached full screen: swap in the next level once the
+                    // loader has it, holding the screen covered until then
+                    if (transitionRadius >= transitionMaxRadius && !replayButton(rep, REPLAY_LEVEL_READY, levelLoaderReady(loader, level))) {
+                        transitionRadius = transitionMaxRadius;
+                    }
+                    else if (transitionRadius >= transitionMaxRadius) {
                         transitionPhaseLoad = true;
                         // --- load new world here (same code as before) ---
-                        mapFree(map);
-                        hashFree(offgridMap);
-                        hashFree(mData.enemies);
-                        hashFree(mData.computers);
+                        mapFree(mData);
                         if (allBirds) free_dynarray(allBirds);
-                        if (flockGrid) hashFree(flockGrid);
-                        allBirds = create_dynarray(&free, NULL);
-                        flockGrid = hashCreate(NULL, &free_dynarray, NULL);
-                        data->flockGrid = flockGrid;
+                        allBirds = create_dynarray(NULL, NULL);
 
-                        offgridMap = hashCreate(NULL, &offgridsFree, NULL);
-                        mData = mapCreate(offgridMap, biome_data, pathDirt, level);
+                        mData = levelLoaderTake(loader, level);
+                        levelLoaderRequest(loader, level + 1);
+                        if (!replayPlaying(rep)) mapSave(levelSavePath(), mData, worldSeed, level);
+                        MapInvalidateCache();
+                        lightingInvalidate();
                         map = mData.map;
                         computers = mData.computers;
-                        player->pos = mapFindSpawnTopLeft(map);
-                        InitBirds(map, flockGrid, allBirds, &walkableTiles);
+                        player->pos = mData.spawn;
+                        InitBirds(mData, allBirds);
                         player->rect.x = player->pos.x;
                         player->rect.y = player->pos.y;
                         g = guns[GetRandomValue(0, 3)];
@@ -1946,25 +1996,25 @@ int main() {
                 if (deathPhaseIn) {
                     // fade in
                     deathFade += delta / deathFadeSpeed;
-                    if (deathFade >= 1.0f) {
+                    if (deathFade >= 1.0f && !replayButton(rep, REPLAY_LEVEL_READY, levelLoaderReady(loader, level))) {
+                        deathFade = 1.0f;
+                    }
+                    else if (deathFade >= 1.0f) {
                         deathFade = 1.0f;
                         // reset map/player here
-                        mapFree(map);
-                        hashFree(offgridMap);
-                        hashFree(mData.enemies);
-                        hashFree(mData.computers);
+                        mapFree(mData);
                         if (allBirds) free_dynarray(allBirds);
-                        if (flockGrid) hashFree(flockGrid);
-                        allBirds = create_dynarray(&free, NULL);
-                        flockGrid = hashCreate(NULL, &free_dynarray, NULL);
-                        data->flockGrid = flockGrid;
+                        allBirds = create_dynarray(NULL, NULL);
 
-                        offgridMap = hashCreate(NULL, &offgridsFree, NULL);
-                        mData = mapCreate(offgridMap, biome_data, pathDirt, level);
+                        mData = levelLoaderTake(loader, level);
+                        levelLoaderRequest(loader, level + 1);
+                        if (!replayPlaying(rep)) mapSave(levelSavePath(), mData, worldSeed, level);
+                        MapInvalidateCache();
+                        lightingInvalidate();
                         map = mData.map;
                         computers = mData.computers;
-                        player->pos = mapFindSpawnTopLeft(map);
-                        InitBirds(map, flockGrid, allBirds, &walkableTiles);
+                        player->pos = mData.spawn;
+                        InitBirds(mData, allBirds);
                         player->rect.x = player->pos.x;
                         player->rect.y = player->pos.y;
                         g = guns[GetRandomValue(0, 3)];
@@ -1997,32 +2047,56 @@ int main() {
 
         }
 
-        collidingComputer = false;
-        currComputer = NULL;
+        // Broadphase for this tick: computers now, enemies once they have moved
+        spatialClear(broadphase, (Rectangle){ roomX * ROOM_SIZE, roomY * ROOM_SIZE, ROOM_SIZE, ROOM_SIZE });
         if ((computer = hashFind(computers, enemyKey)) != NULL){
             for (int i = 0; i < computer->len; i++){
                 Computer comp = computer->data[i];
-                if (CheckCollisionRecs(comp->e->rect, player->rect)){
-                    collidingComputer = true;
-                    currComputer = comp;
-                }
+                spatialInsert(broadphase, comp->e->rect, SPATIAL_COMPUTER, comp);
             }
         }
+
+        currComputer = NULL;
+        spatialQueryRect(broadphase, player->rect, SPATIAL_COMPUTER, (void **)&currComputer, 1);
+        collidingComputer = currComputer != NULL;
+
+        // Intents: enemy sensing, bird steering and npc movement only read
+        // the map and write their own entity, so they run across the job
+        // pool; everything that shoots, rolls dice or draws stays serial
+        enemyCount = enemyRoom(mData.enemies, roomX, roomY, &enemies);
+        enemyHandle sensing[ENEMY_SENSE_BUDGET];
+        int sensingCount = enemySenseSchedule(mData.enemies, enemies, enemyCount, player, isHacking, sensing);
+        npcs = mapChunkNpcs(map, roomX, roomY);
+        struct intentsData intents = { mData.enemies, sensing, npcs, player, map, isHacking };
+        data->playerPos = player->pos;
+        int flying = gatherSteering(allBirds, data);
+        jobTask intentJobs[] = {
+            { sensingCount, 1, &senseEnemies, &intents },
+            { flying, 64, &steerBirds, data },
+            { npcs ? npcs->count : 0, 4, &moveNpcs, &intents },
+        };
+        jobsRun(intentJobs, 3);
+        updateBoids(allBirds);
         double t_logic_end = GetTime();
 
         double t_draw_start = GetTime();
         // --- Drawing ---
+        lightingSetRoom(map, roomX, roomY);
+        if (muzzleFlash > 0.0f) {
+            lightingAddPoint(player->pos, MUZZLE_FLASH_RADIUS, ColorAlpha((Color){255, 200, 100, 255}, 0.6f * muzzleFlash / MUZZLE_FLASH_TIME));
+            muzzleFlash -= delta;
+        }
         BeginTextureMode(target);
             ClearBackground((Color) {0, 0, 0, 0});
             BeginMode2D(camera);
                 MapDrawCached(camera);
-                // if ((offgrids = hashFind(offgridMap, enemyKey)) != NULL){
+                // if ((offgrids = hashFind(mData.offgrids, enemyKey)) != NULL){
                 //     for (int i = 0; i < offgrids->len; i++){
                 //         offgridTile o = (offgridTile) offgrids->data[i];
                 //         DrawTexture(o->texture, o->x , o->y , WHITE);
                 //     }
                 // }
-                if ((offgrids = hashFind(offgridMap, enemyKey)) != NULL) {
+                if ((offgrids = mapChunkOffgrids(map, roomX, roomY)) != NULL) {
                     // compute world-space screen rect once
                     Rectangle screenWorld = {
                         camera.target.x - (SCREEN_WIDTH / 2) / camera.zoom,
@@ -2048,13 +2122,14 @@ int main() {
                     }
                 }
 
-                if ((enemies = hashFind(mData.enemies, enemyKey)) != NULL) {
-                    for (int i = 0; i < enemies->len; i++) {
-                        Enemy e = enemies->data[i];
-                        Vector2 vel = computeVelOfEnemy(e, player, map, eprojectiles, isHacking);
-                        update(e->e, map, vel);
-                        enemyDraw(e, player, map, EnemyAnimations, enemyGunTex);
-                    }
+                // the broadphase holds enemy handles, not pointers
+                enemyCount = enemyRoom(mData.enemies, roomX, roomY, &enemies);
+                for (int i = 0; i < enemyCount; i++) {
+                    Enemy e = enemyGet(mData.enemies, enemies[i]);
+                    Vector2 vel = computeVelOfEnemy(e, player, map, eprojectiles, isHacking);
+                    update(e->e, map, vel);
+                    spatialInsert(broadphase, e->e->rect, SPATIAL_ENEMY, (void *)(uintptr_t)enemies[i]);
+                    enemyDraw(e, player, EnemyAnimations, enemyGunTex);
                 }
                 if ((computer = hashFind(computers, enemyKey)) != NULL){
                     for (int i = 0; i < computer->len; i++){
@@ -2064,11 +2139,11 @@ int main() {
                 }
 
                 // Draw NPCS
-                if ((npcs = hashFind(mData.npcs, enemyKey)) != NULL){
-                    for (int i = 0; i < npcs->len; i++){
-                        NPC n = npcs->data[i];
-                        npcUpdate(n, map);
-                        Texture2D npcFrame = NPCAnimations[n->type][n->state]->frames[n->currentFrame];
+                if ((npcs = mapChunkNpcs(map, roomX, roomY)) != NULL){
+                    for (int i = 0; i < npcs->count; i++){
+                        NPC n = &npcs->npcs[i];
+                        npcUpdate(n);
+                        Texture2D npcFrame = NPCAnimations[n->type][n->hot->state]->frames[n->currentFrame];
                         // Flip based on facingRight using DrawTexturePro
                         Rectangle nsrc = (Rectangle){ 0, 0, (float)npcFrame.width * n->facingRight, (float)npcFrame.height };
                         Rectangle ndst = (Rectangle){ n->e->rect.x, n->e->rect.y, (float)npcFrame.width, (float)npcFrame.height };
@@ -2117,7 +2192,7 @@ int main() {
                 updateCoins(coins, player, 0.5f, &currency);
                 drawCoins(coins);
 
-                DrawBoids(flockGrid);
+                DrawBoids(allBirds);
 
 
                 int pos = 0;
@@ -2138,47 +2213,34 @@ int main() {
                         continue;
                     }
 
-                    bool removedProjectile = false;
-
-                    if ((enemies = hashFind(mData.enemies, enemyKey)) != NULL){
-                        int epos = 0;
-                        while (epos < enemies->len){
-                            Enemy e = enemies->data[epos];
-
-                            if (CheckCollisionRecs(e->e->rect, p->e->rect)){
-                                if (p->gunType == SHOTGUN){
-                                    // e->health -= (g.damage / Vector2Distance(p->startPos, e->e->pos));
-                                    float dist = Vector2Distance(p->startPos, e->e->pos);
-                                    float falloff = 50.0f; // tweak falloff strength
-                                    float dmg = g.damage * (falloff / (dist + falloff));
-                                    e->health -= dmg;
-                                }
-                                else{
-                                    e->health -= g.damage;
-                                }
-                                e->state = ACTIVE;
-                                // Impact_HitFlashTrigger(&e->flash )
-                                Impact_SpawnBurst((Vector2){p->e->rect.x, p->e->rect.y}, RED, 8);
-                                Impact_StartShake(0.15f, 3.0f);
-                                remove_dynarray(projectiles, pos);
-                                removedProjectile = true;
-
-                                if (e->health <= 0){
-                                    remove_dynarray(enemies, epos);
-
-                                    // Spawn coins
-                                    spawnCoins(coins, e->e->pos, 20);
-                                }
-
-                                break;
-                            }
-
-
-                            epos += 1;
+                    void *hit = NULL;
+                    Enemy e = NULL;
+                    if (spatialQueryRect(broadphase, p->e->rect, SPATIAL_ENEMY, &hit, 1) > 0
+                        && (e = enemyGet(mData.enemies, (enemyHandle)(uintptr_t)hit)) != NULL){
+                        if (p->gunType == SHOTGUN){
+                            // e->health -= (g.damage / Vector2Distance(p->startPos, e->e->pos));
+                            float dist = Vector2Distance(p->startPos, e->e->pos);
+                            float falloff = 50.0f; // tweak falloff strength
+                            float dmg = g.damage * (falloff / (dist + falloff));
+                            e->health -= dmg;
                         }
-                    }
+                        else{
+                            e->health -= g.damage;
+                        }
+                        e->hot->state = ACTIVE;
+                        // Impact_HitFlashTrigger(&e->flash )
+                        Impact_SpawnBurst((Vector2){p->e->rect.x, p->e->rect.y}, RED, 8);
+                        Impact_StartShake(0.15f, 3.0f);
+                        sfxPlayAt(e->health <= 0 ? SFX_KILL : SFX_HIT, e->e->pos, player->pos);
+                        remove_dynarray(projectiles, pos);
+
+                        if (e->health <= 0){
+                            // Spawn coins
+                            spawnCoins(coins, e->e->pos, 20);
 
-                    if (removedProjectile) {
+                            spatialRemove(broadphase, e->e->rect, hit);
+                            enemyKill(mData.enemies, (enemyHandle)(uintptr_t)hit);
+                        }
                         continue;
                     }
 
@@ -2196,10 +2258,12 @@ int main() {
                     }
                     if (CheckCollisionRecs(player->rect, p->e->rect)){
                         health -= 1;
+                        sfxPlay(SFX_HURT, 1.0f, 0.0f);
                         Impact_SpawnBurst((Vector2){player->rect.x, player->rect.y}, PURPLE, 10);
                         Impact_StartShake(1.0f, 4.0f);
                         if (health <= 0 && playerAlive){
                             playerAlive = false;
+                            levelLoaderRequest(loader, level);
                             // Start death transition (fade to red)
                             transitionType = TT_DEATH;
                             transitioning = true;
@@ -2242,6 +2306,7 @@ int main() {
 
             // DrawText(TextFormat("fps: %d", GetFPS()), 10, 10, 10, RED);
         EndTextureMode();
+        lightingRender(camera);
         double t_draw_end = GetTime();
 
         double t_present_start = GetTime();
@@ -2252,6 +2317,7 @@ int main() {
             src = (Rectangle) { 0, 0, (float)target.texture.width, -(float)target.texture.height };
             dst = (Rectangle) { 0, 0, (float)SCREEN_WIDTH * 2, (float)SCREEN_HEIGHT * 2 };
             BeginShaderMode(shader);
+            SetShaderValueTexture(shader, lightmapLoc, lightingTexture());
             DrawTexturePro(target.texture, src, dst, (Vector2){0, 0}, 0.0f, WHITE);
             EndShaderMode();
 
@@ -2292,7 +2358,7 @@ int main() {
                         fontSize, WHITE);
 
                 // Handle click
-                if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && hovering) {
+                if (replayButton(rep, REPLAY_HACK, IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && hovering)) {
                     isHacking = !isHacking;  // toggle hack mode
                     if (isHacking){
                         player->pos.x = currComputer->e->pos.x + currComputer->e->rect.width / 2 - player->rect.width;
@@ -2369,19 +2435,35 @@ int main() {
         //     (t_draw_end - t_draw_start) * 1000.0,
         //     (t_present_end - t_present_start) * 1000.0
         // );
+        sfxFlush();
+        replayEndFrame(rep);
     }
 
-    // Unload music
-    StopMusicStream(bgm);
-    UnloadMusicStream(bgm);
-
     UnloadRenderTexture(target);
-    mapFree(map);
+    lightingUnload();
+    birdDrawUnload();
+    spatialFree(broadphase);
+    replayClose(rep);
+    levelLoaderFree(loader);
+    jobsShutdown();
+    mapFree(mData);
     if (allBirds) free_dynarray(allBirds);
-    if (walkableTiles) free_dynarray(walkableTiles);
-    if (flockGrid) hashFree(flockGrid);
+    cellGridFree(data->grid);
+    free(data->gathered);
+    free(data->gatheredPos);
+    free(data->birds);
+    flockRelease(&data->kin);
     free(data);
-
+    cellGridFree(startle->rooms);
+    cellGridFree(startle->idle);
+    free(startle->pos);
+    free(startle->nearby);
+    free(startle->idleBirds);
+    free(startle->frontier);
+    free(startle);
+
+    musicShutdown();
+    sfxUnload();
     CloseAudioDevice();
     CloseWindow();
     return 0;
@@ -15,14 +15,33 @@
 #include "noise.h"
 #include "computer.h"
 #include "npc.h"
+#include "rng.h"
+#include "jobs.h"
+
+#if !defined(_WIN32) && !defined(PLATFORM_WEB)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+// Same platforms as the texture pack in pack.c
+#if defined(__unix__) && !defined(PLATFORM_ANDROID) && !defined(PLATFORM_WEB)
+#define LEVEL_FILE_MMAP
+#endif
 
 static inline int clampi(int v, int lo, int hi){ return v < lo ? lo : (v > hi ? hi : v); }
 
+// rng streams drawn from a level seed. Every chunk gets its own so chunks
+// can be generated in any order without changing the result.
+#define STREAM_LEVEL   0
+#define STREAM_LINKS   1
+#define STREAM_CHUNK   (1 << 16)
+#define STREAM_PROPS   (2 << 16)
+
 typedef struct LevelConfig {
     int worldW, worldH;         // chunk dims
     float enemyChancePercent;   // per DIRT tile (max percent, e.g. 1.0 means 1%)
     int maxEnemiesPerChunk;     // cap per chunk
-    int globalEnemyCap;         // overall cap
 } LevelConfig;
 
 // Tiered world sizes
@@ -33,9 +52,11 @@ static const int tier3[][2] = { {1,1}, {1,2}, {2,1},
 static const int tier4[][2] = { {1,1}, {1,2}, {2,1}, 
                                 {2,2}, {1,3}, {3,1},
                                 {2,3}, {3,2}, {3,3} };    // full set
+static const int tier5[][2] = { {3,3}, {3,4}, {4,3},
+                                {4,4}, {4,5}, {5,4} };    // past the resident budget, see mapStreamAround
 
 
-static LevelConfig LevelConfigFromLevel(int level) {
+static LevelConfig LevelConfigFromLevel(int level, rng *r) {
     if (level < 1) level = 1;
 
     const int (*pool)[2];
@@ -50,13 +71,16 @@ static LevelConfig LevelConfigFromLevel(int level) {
     } else if (level <= 13) {
         pool = tier3;
         poolSize = sizeof(tier3)/sizeof(tier3[0]);
-    } else {
+    } else if (level <= 21) {
         pool = tier4;
         poolSize = sizeof(tier4)/sizeof(tier4[0]);
+    } else {
+        pool = tier5;
+        poolSize = sizeof(tier5)/sizeof(tier5[0]);
     }
 
     // Randomly pick a size from unlocked pool
-    int idx = GetRandomValue(0, poolSize - 1);
+    int idx = rngRange(r, 0, poolSize - 1);
     int w = pool[idx][0];
     int h = pool[idx][1];
 
@@ -69,32 +93,13 @@ static LevelConfig LevelConfigFromLevel(int level) {
     enemyChancePercent = fminf(enemyChancePercent, maxChance);
 
     int maxPerChunk = clampi(1 + (level - 1)/2, 1, 4);
-    int globalCap = w * h * maxPerChunk;
 
-    LevelConfig c = { w, h, enemyChancePercent, maxPerChunk, globalCap };
+    LevelConfig c = { w, h, enemyChancePercent, maxPerChunk };
     return c;
 }
 
 
 
-void tilesFree(hashvalue val){
-  rect r = (rect) val; 
-  if (r->node) free(r->node);
-  free(r);
-}
-
-void tilesPrint(FILE *out, hashkey key, hashvalue val){
-  char *k = (char *)key;
-  rect r = (rect)val; 
-  printf("key : %s, tile : %d\n", k, r->tile);
-}
-
-rect mapGetRecAt(hash map, int x, int y){
-  char buffer[22];
-  sprintf(buffer, "%d:%d", x, y);
-  return hashFind(map, buffer);
-}
-
 // #define WORLD_W 3
 // #define WORLD_H 3
 #define DOORS_SIZE (((WORLD_W - 1) * WORLD_H) + ((WORLD_H - 1) * WORLD_W))
@@ -114,9 +119,9 @@ typedef struct {
 
 // dimension-agnostic corridor carving (L-first or V-first, widened)
 static void carve_corridor_grid(TILES *grid, int W, int H,
-                                int x1, int y1, int x2, int y2, int width)
+                                int x1, int y1, int x2, int y2, int width, rng *r)
 {
-    if (rand() & 1) {
+    if (rngNext(r) & 1) {
         // horizontal first
         int xa = (x1 < x2 ? x1 : x2), xb = (x1 > x2 ? x1 : x2);
         for (int x = xa; x <= xb; x++)
@@ -149,7 +154,7 @@ static void carve_corridor_grid(TILES *grid, int W, int H,
 
 
 // -------- generate one chunk ----------
-int generatePuzzleMap(TILES chunk[CHUNK_SIZE][CHUNK_SIZE], Room rooms[MAX_ROOMS]) {
+int generatePuzzleMap(TILES chunk[CHUNK_SIZE][CHUNK_SIZE], Room rooms[MAX_ROOMS], rng *r) {
     // fill
     for (int y=0; y<CHUNK_SIZE; ++y)
         for (int x=0; x<CHUNK_SIZE; ++x)
@@ -158,9 +163,9 @@ int generatePuzzleMap(TILES chunk[CHUNK_SIZE][CHUNK_SIZE], Room rooms[MAX_ROOMS]
     // rooms (keep your overlap logic if you want)
     int roomCount = 0;
     for (int i=0; i<MAX_ROOMS; ++i) {
-        int w = 6 + rand()%6, h = 6 + rand()%6;
-        int x = 2 + rand()%(CHUNK_SIZE - w - 2);
-        int y = 2 + rand()%(CHUNK_SIZE - h - 2);
+        int w = rngRange(r, 6, 11), h = rngRange(r, 6, 11);
+        int x = rngRange(r, 2, CHUNK_SIZE - w - 1);
+        int y = rngRange(r, 2, CHUNK_SIZE - h - 1);
         for (int yy=y; yy<y+h; ++yy)
             for (int xx=x; xx<x+w; ++xx)
                 chunk[yy][xx] = DIRT;
@@ -174,13 +179,13 @@ int generatePuzzleMap(TILES chunk[CHUNK_SIZE][CHUNK_SIZE], Room rooms[MAX_ROOMS]
         int y1 = rooms[i-1].y + rooms[i-1].h/2;
         int x2 = rooms[i].x   + rooms[i].w/2;
         int y2 = rooms[i].y   + rooms[i].h/2;
-        carve_corridor_grid(&chunk[0][0], CHUNK_SIZE, CHUNK_SIZE, x1,y1,x2,y2,corridorWidth);
+        carve_corridor_grid(&chunk[0][0], CHUNK_SIZE, CHUNK_SIZE, x1,y1,x2,y2,corridorWidth,r);
 
-        if ((rand()%3)==0) { // an extra loop edge
-            int j = rand()%i;
+        if (rngRange(r, 0, 2) == 0) { // an extra loop edge
+            int j = rngRange(r, 0, i - 1);
             int rx = rooms[j].x + rooms[j].w/2;
             int ry = rooms[j].y + rooms[j].h/2;
-            carve_corridor_grid(&chunk[0][0], CHUNK_SIZE, CHUNK_SIZE, x1,y1,rx,ry,corridorWidth);
+            carve_corridor_grid(&chunk[0][0], CHUNK_SIZE, CHUNK_SIZE, x1,y1,rx,ry,corridorWidth,r);
         }
     }
 
@@ -230,7 +235,7 @@ static Room* pick_northmost(Room *rs, int n) {
 static void connect_room_centers_world(TILES *world, int W, int H,
                                        Room *a, int ax, int ay,
                                        Room *b, int bx, int by,
-                                       int corridorWidth)
+                                       int corridorWidth, rng *r)
 {
     // room centers in *world tile* coords
     int x1 = a->x + a->w/2 + ax*CHUNK_SIZE;
@@ -239,153 +244,123 @@ static void connect_room_centers_world(TILES *world, int W, int H,
     int y2 = b->y + b->h/2 + by*CHUNK_SIZE;
 
     // 1) carve the corridor (random L orientation inside)
-    carve_corridor_grid(world, W, H, x1, y1, x2, y2, corridorWidth);
-}
-
-static void computerFree(DA_ELEMENT el){
-    Computer c = (Computer) el; 
-    free(c->e);
+    carve_corridor_grid(world, W, H, x1, y1, x2, y2, corridorWidth, r);
 }
 
-void generateWorld(TILES *world, hash enemies, hash computers, int *noOfComputers, int WORLD_W, int WORLD_H, LevelConfig config) {
-     Room worldRooms[WORLD_H][WORLD_W][MAX_ROOMS];
-     int roomCount[WORLD_H][WORLD_W];
-     int globalSpawned = 0;
-
-     int GAME_WIDTH = WORLD_W * CHUNK_SIZE;
-     int GAME_HEIGHT = WORLD_H * CHUNK_SIZE;
-
-     // fill with stone
-    for (int y=0;y<GAME_HEIGHT;y++)
-        for (int x=0;x<GAME_WIDTH;x++)
-            world[y*GAME_WIDTH + x] = STONE;
-
-    char buffer[22];
-    dynarray enemy;
-    dynarray computer;
-
-    // generate chunks and paste
-    for (int cy=0; cy<WORLD_H; cy++){
-        for (int cx=0; cx<WORLD_W; cx++){
-            int chunkSpawned = 0;
-            TILES chunk[CHUNK_SIZE][CHUNK_SIZE];
-            int cnt = generatePuzzleMap(chunk, worldRooms[cy][cx]);
-            roomCount[cy][cx] = cnt;
-
-            // --- Spawn one computer per chunk ---
-            int dirtCount = 0;
-            int dirtXs[CHUNK_SIZE * CHUNK_SIZE], dirtYs[CHUNK_SIZE * CHUNK_SIZE];
-            for (int y = 0; y < CHUNK_SIZE; y++) {
-                for (int x = 0; x < CHUNK_SIZE; x++) {
-                    if (chunk[y][x] == DIRT) {
-                        dirtXs[dirtCount] = x;
-                        dirtYs[dirtCount] = y;
-                        dirtCount++;
-                    }
-                }
-            }
-            if (dirtCount > 0) {
-                int pick = GetRandomValue(0, dirtCount - 1);
-                int rx = dirtXs[pick];
-                int ry = dirtYs[pick];
-                // World coordinates
-                int wx = cx * CHUNK_SIZE + rx;
-                int wy = cy * CHUNK_SIZE + ry;
-
-                Computer comp = malloc(sizeof(struct Computer));
-                assert(comp != NULL);
-                comp->e = entityCreate(wx * TILE_SIZE, wy * TILE_SIZE, 15, 15);
-                comp->hacked = false;
-                comp->amountLeftToHack = 100;
-                (*noOfComputers) += 1;
-                sprintf(buffer, "%d:%d", cx, cy);
-                if (hashFind(computers, buffer) == NULL){
-                    hashSet(computers, buffer, create_dynarray(&computerFree, NULL));
-                }
-                if ((computer = hashFind(computers, buffer)) != NULL){
-                    add_dynarray(computer, comp);
-                }
+// Everything one chunk produces while it is generated on its own. Chunk
+// jobs only write to their own chunkGen and their own part of the world
+// grid; the lists and arena are handed to the level once all are done.
+typedef struct chunkGen{
+    int cx, cy;
+    arena a;
+    Room rooms[MAX_ROOMS];
+    int roomCount;
+    enemySpawn *enemies;
+    int enemyCount;
+    dynarray computers;
+} chunkGen;
+
+typedef struct worldGen{
+    uint64_t seed;
+    LevelConfig config;
+    int chunksW, chunksH;
+    int W, H;                   // in tiles
+    TILES *world;
+    unsigned char *kinds;       // W * H, StoneVariant or KIND_FLOOR
+    chunkGen *chunks;
+} worldGen;
+
+#define CHUNK_ARENA_BLOCK (32 * 1024)
+
+// Job: carve one chunk into the world grid and pick its computer and enemy spots.
+static void carveChunkJob(void *ctx, int i){
+    worldGen *g = ctx;
+    chunkGen *c = &g->chunks[i];
+    rng cr;
+    rng *r = &cr;
+    rngSeed(r, g->seed, STREAM_CHUNK + i);
+
+    c->a = arenaCreate(CHUNK_ARENA_BLOCK);
+    int maxEnemies = g->config.maxEnemiesPerChunk;
+    c->enemies = arenaAlloc(c->a, (maxEnemies > 0 ? maxEnemies : 1) * sizeof(enemySpawn));
+    c->enemyCount = 0;
+    c->computers = create_dynarray(NULL, NULL);
+
+    TILES chunk[CHUNK_SIZE][CHUNK_SIZE];
+    c->roomCount = generatePuzzleMap(chunk, c->rooms, r);
+
+    // --- Spawn one computer per chunk ---
+    int dirtCount = 0;
+    int dirtXs[CHUNK_SIZE * CHUNK_SIZE], dirtYs[CHUNK_SIZE * CHUNK_SIZE];
+    for (int y = 0; y < CHUNK_SIZE; y++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            if (chunk[y][x] == DIRT) {
+                dirtXs[dirtCount] = x;
+                dirtYs[dirtCount] = y;
+                dirtCount++;
             }
+        }
+    }
+    if (dirtCount > 0) {
+        int pick = rngRange(r, 0, dirtCount - 1);
+        int wx = c->cx * CHUNK_SIZE + dirtXs[pick];
+        int wy = c->cy * CHUNK_SIZE + dirtYs[pick];
+
+        Computer comp = arenaAlloc(c->a, sizeof(struct Computer));
+        comp->e = entityCreateIn(c->a, wx * TILE_SIZE, wy * TILE_SIZE, 15, 15);
+        comp->hacked = false;
+        comp->amountLeftToHack = 100;
+        add_dynarray(c->computers, comp);
+    }
 
-            // --- Enemy spawn as before ---
-            for (int y=0; y<CHUNK_SIZE; y++){
-                for (int x=0; x<CHUNK_SIZE; x++){
-                    // if (chunk[y][x] == DIRT && GetRandomValue(1,100) == 2){
-                    //     // Spawn an enemy in this location 
-                    //     Enemy e = enemyCreate(
-                    //         (cx * CHUNK_SIZE + x) * TILE_SIZE, 
-                    //         (cy * CHUNK_SIZE + y) * TILE_SIZE,
-                    //         15, 
-                    //         15
-                    //     );
-                    //     sprintf(buffer, "%d:%d", cx, cy); 
-                    //     if (hashFind(enemies, buffer) == NULL){
-                    //         hashSet(enemies, buffer, create_dynarray(&enemyFree, NULL));
-                    //     }
-                    //     if ((enemy = hashFind(enemies, buffer)) != NULL){
-                    //         add_dynarray(enemy, e);
-                    //     }
-                    // }
-                    // int wx = cx*CHUNK_SIZE + x;
-                    // int wy = cy*CHUNK_SIZE + y;
-                    // world[wy*GAME_WIDTH + wx] = chunk[y][x];
-
-                    int wx = cx * CHUNK_SIZE + x;
-                    int wy = cy * CHUNK_SIZE + y;
-                    world[wy * GAME_WIDTH + wx] = chunk[y][x];
-
-                    // spawn only on DIRT, only while under per-chunk and global caps
-                    if (chunk[y][x] != DIRT) continue;
-                    if (chunkSpawned >= config.maxEnemiesPerChunk) continue;
-                    if (globalSpawned >= config.globalEnemyCap) continue;
-
-                    // convert percent to hundredths of a percent (1.00% -> 100)
-                    // we'll compare against a 1..10000 random range (so 100 => 1%)
-                    int chanceHundredths = (int) roundf(config.enemyChancePercent * 100.0f);
-                    // skip if chance is zero (defensive)
-                    if (chanceHundredths <= 0) continue;
-
-                    // do random check (GetRandomValue is inclusive)
-                    if (GetRandomValue(1, 10000) <= chanceHundredths) {
-                        // Spawn an enemy in this location
-                        Enemy e = enemyCreate(
-                            wx * TILE_SIZE,
-                            wy * TILE_SIZE,
-                            15,
-                            15
-                        );
-                        char buffer[22];
-                        sprintf(buffer, "%d:%d", cx, cy);
-                        if (hashFind(enemies, buffer) == NULL){
-                            hashSet(enemies, buffer, create_dynarray(&enemyFree, NULL));
-                        }
-                        dynarray enemyArr = hashFind(enemies, buffer);
-                        if (enemyArr != NULL){
-                            add_dynarray(enemyArr, e);
-                        }
-
-                        chunkSpawned++;
-                        globalSpawned++;
-                        // if we reached either cap, we will naturally skip further spawns
-                    }
-
-                }
+    // convert percent to hundredths of a percent (1.00% -> 100)
+    // we'll compare against a 1..10000 random range (so 100 => 1%)
+    int chanceHundredths = (int) roundf(g->config.enemyChancePercent * 100.0f);
+
+    // --- Enemy spawn, and paste the chunk into the world ---
+    for (int y=0; y<CHUNK_SIZE; y++){
+        for (int x=0; x<CHUNK_SIZE; x++){
+            int wx = c->cx * CHUNK_SIZE + x;
+            int wy = c->cy * CHUNK_SIZE + y;
+            g->world[wy * g->W + wx] = chunk[y][x];
+
+            // spawn only on DIRT, only while under the per-chunk cap
+            if (chunk[y][x] != DIRT) continue;
+            if (c->enemyCount >= maxEnemies) continue;
+            // skip if chance is zero (defensive)
+            if (chanceHundredths <= 0) continue;
+
+            // do random check (rngRange is inclusive)
+            if (rngRange(r, 1, 10000) <= chanceHundredths) {
+                c->enemies[c->enemyCount++] = enemySpawnRoll(r, wx * TILE_SIZE, wy * TILE_SIZE);
             }
         }
     }
+}
+
+// Serial step between the chunk jobs: corridors across chunk borders.
+static void stitchChunks(worldGen *g){
+    rng lr;
+    rng *r = &lr;
+    rngSeed(r, g->seed, STREAM_LINKS);
+    TILES *world = g->world;
+    int WORLD_W = g->chunksW, WORLD_H = g->chunksH;
+    int GAME_WIDTH = g->W, GAME_HEIGHT = g->H;
+    #define CHUNK_AT(cx, cy) (&g->chunks[(cy) * WORLD_W + (cx)])
 
     // connect horizontally (two connectors per border)
     for (int cy=0; cy<WORLD_H; cy++){
         for (int cx=0; cx<WORLD_W-1; cx++){
-            if (roomCount[cy][cx] && roomCount[cy][cx+1]){
-                Room *leftA  = pick_eastmost(worldRooms[cy][cx],   roomCount[cy][cx]);
-                Room *rightB = pick_westmost(worldRooms[cy][cx+1], roomCount[cy][cx+1]);
-                if (leftA && rightB) connect_room_centers_world(world, GAME_WIDTH, GAME_HEIGHT, leftA, cx, cy, rightB, cx+1, cy, 3);
+            chunkGen *a = CHUNK_AT(cx, cy), *b = CHUNK_AT(cx+1, cy);
+            if (a->roomCount && b->roomCount){
+                Room *leftA  = pick_eastmost(a->rooms, a->roomCount);
+                Room *rightB = pick_westmost(b->rooms, b->roomCount);
+                if (leftA && rightB) connect_room_centers_world(world, GAME_WIDTH, GAME_HEIGHT, leftA, cx, cy, rightB, cx+1, cy, 3, r);
 
                 // second redundancy: random rooms
-                Room *ra = &worldRooms[cy][cx][rand()%roomCount[cy][cx]];
-                Room *rb = &worldRooms[cy][cx+1][rand()%roomCount[cy][cx+1]];
-                connect_room_centers_world(world, GAME_WIDTH, GAME_HEIGHT, ra, cx, cy, rb, cx+1, cy, 3);
+                Room *ra = &a->rooms[rngRange(r, 0, a->roomCount - 1)];
+                Room *rb = &b->rooms[rngRange(r, 0, b->roomCount - 1)];
+                connect_room_centers_world(world, GAME_WIDTH, GAME_HEIGHT, ra, cx, cy, rb, cx+1, cy, 3, r);
             }
         }
     }
@@ -393,20 +368,19 @@ void generateWorld(TILES *world, hash enemies, hash computers, int *noOfComputer
     // connect vertically (two connectors per border)
     for (int cy=0; cy<WORLD_H-1; cy++){
         for (int cx=0; cx<WORLD_W; cx++){
-            if (roomCount[cy][cx] && roomCount[cy+1][cx]){
-                Room *topA  = pick_southmost(worldRooms[cy][cx],     roomCount[cy][cx]);
-                Room *botB  = pick_northmost(worldRooms[cy+1][cx],   roomCount[cy+1][cx]);
-                if (topA && botB) connect_room_centers_world(world, GAME_WIDTH, GAME_HEIGHT, topA, cx, cy, botB, cx, cy+1, 3);
-
-                Room *ra = &worldRooms[cy][cx][rand()%roomCount[cy][cx]];
-                Room *rb = &worldRooms[cy+1][cx][rand()%roomCount[cy+1][cx]];
-                connect_room_centers_world(world, GAME_WIDTH, GAME_HEIGHT, ra, cx, cy, rb, cx, cy+1, 3);
+            chunkGen *a = CHUNK_AT(cx, cy), *b = CHUNK_AT(cx, cy+1);
+            if (a->roomCount && b->roomCount){
+                Room *topA  = pick_southmost(a->rooms, a->roomCount);
+                Room *botB  = pick_northmost(b->rooms, b->roomCount);
+                if (topA && botB) connect_room_centers_world(world, GAME_WIDTH, GAME_HEIGHT, topA, cx, cy, botB, cx, cy+1, 3, r);
+
+                Room *ra = &a->rooms[rngRange(r, 0, a->roomCount - 1)];
+                Room *rb = &b->rooms[rngRange(r, 0, b->roomCount - 1)];
+                connect_room_centers_world(world, GAME_WIDTH, GAME_HEIGHT, ra, cx, cy, rb, cx, cy+1, 3, r);
             }
         }
     }
-
-    // return enemies;
-    // return doors;
+    #undef CHUNK_AT
 
     // (optional but recommended) flood-fill connectivity fixup:
     // If some DIRT is isolated, punch a minimal corridor through the nearest wall.
@@ -415,7 +389,7 @@ void generateWorld(TILES *world, hash enemies, hash computers, int *noOfComputer
 
 // Find a spawn position inside the top-left chunk (chunk 0,0).
 // Returns world coordinates (tile-center). Caller may offset by entity half-size.
-Vector2 mapFindSpawnTopLeft(hash map) {
+Vector2 mapFindSpawnTopLeft(tilemap map) {
     int chunkX = 0;
     int chunkY = 0;
 
@@ -425,13 +399,10 @@ Vector2 mapFindSpawnTopLeft(hash map) {
     int endX   = startX + CHUNK_SIZE;
     int endY   = startY + CHUNK_SIZE;
 
-    char buffer[22];
-
     // scan only the top-left chunk
     for (int y = startY; y < endY; y++) {
         for (int x = startX; x < endX; x++) {
-            sprintf(buffer, "%d:%d", x, y);
-            rect r = hashFind(map, buffer);
+            rect r = mapGetRecAt(map, x, y);
             if (r && r->tile == DIRT) {
                 // found first floor tile inside chunk (0,0)
                 return (Vector2){
@@ -465,46 +436,65 @@ void printMap(TILES map[HEIGHT][WIDTH]) {
 //  6: top_left,    7: top_right,    8: top]
 
 
-static inline TILES getTileSafe(TILES *m, int x, int y, int W, int H) {
-    if (x < 0 || y < 0 || x >= W || y >= H) return STONE;
-    return m[y*W + x];
-}
-
-static int chooseStoneVariant(TILES *m, int x, int y, int W, int H) {
-    if (getTileSafe(m, x, y, W, H) != STONE) return STONE_MIDDLE;
-
-    // check surroundings
-    bool t  = (getTileSafe(m, x,   y-1, W, H) == DIRT);
-    bool b  = (getTileSafe(m, x,   y+1, W, H) == DIRT);
-    bool l  = (getTileSafe(m, x-1, y,   W, H) == DIRT);
-    bool r  = (getTileSafe(m, x+1, y,   W, H) == DIRT);
-
-    int mask = (t ? 1 : 0) | (b ? 2 : 0) | (l ? 4 : 0) | (r ? 8 : 0);
-
-    int base = STONE_MIDDLE;
-
-    // basic tiles
-    if (mask == 1)        base = STONE_TOP;
-    else if (mask == 2)   base = STONE_BOTTOM;
-    else if (mask == 4)   base = STONE_LEFT;
-    else if (mask == 8)   base = STONE_RIGHT;
-    else if (mask == (2|4)) base = STONE_BL;
-    else if (mask == (2|8)) base = STONE_BR;
-    else if (mask == (1|4)) base = STONE_TL;
-    else if (mask == (1|8)) base = STONE_TR;
-
-    // --- optional: horizontal stacking for left / right ---
-    // if you have _1 variants for left/right, enable them:
-    // if ((base == STONE_LEFT || base == STONE_RIGHT) &&
-    //     getTileSafe(m, x + (base == STONE_RIGHT ? 1 : -1), y) == STONE)
-    // {
-    //     return (base == STONE_LEFT ? STONE_LEFT_1 : STONE_RIGHT_1);
-    // }
-
-    return base;
+// Autotiling works on the 4-neighbour dirt mask of a stone tile:
+// 1 = dirt above, 2 = below, 4 = left, 8 = right (off the map counts as stone).
+// Stone with dirt on two opposite sides is cleared to floor.
+#define KIND_FLOOR 0xFF
+
+static const unsigned char stoneForMask[16] = {
+    STONE_MIDDLE, STONE_TOP,  STONE_BOTTOM, KIND_FLOOR,     // 0  1  2  3
+    STONE_LEFT,   STONE_TL,   STONE_BL,     KIND_FLOOR,     // 4  5  6  7
+    STONE_RIGHT,  STONE_TR,   STONE_BR,     KIND_FLOOR,     // 8  9  10 11
+    KIND_FLOOR,   KIND_FLOOR, KIND_FLOOR,   KIND_FLOOR      // 12 13 14 15
+};
+
+// Stone sitting on top of these bottom edge pieces uses the taller _1
+// piece; -1 leaves it alone.
+static const signed char stoneAbove[12] = {
+    STONE_BL_1, STONE_BR_1, STONE_BOTTOM_1,     // BL, BR, BOTTOM
+    -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+// ------------ chunk streaming -------------
+// Carving and autotiling only need a byte per tile, so a level keeps its
+// whole `kinds` grid. The rects, path nodes, props and NPCs built from it
+// cost ~300KB a chunk; those are paged in around the player and the least
+// recently used chunks are dropped past MAP_RESIDENT_CHUNKS. A chunk is
+// rebuilt from the level seed, so it comes back exactly as it left,
+// except that its NPCs start over from where they spawned.
+#define MAP_RESIDENT_CHUNKS 12
+#define MAP_SPARE_CHUNKS 4
+#define CHUNK_TILES (CHUNK_SIZE * CHUNK_SIZE)
+
+typedef struct tileChunk{
+    int cx, cy;
+    unsigned lastUsed;          // tilemap clock of the last touch
+    arena a;                    // props and NPCs
+    dynarray offgrids;
+    npcGroup npcs;
+    struct rect rects[CHUNK_TILES];
+    struct pathNode nodes[CHUNK_TILES];
+} *tileChunk;
+
+struct tilemap{
+    uint64_t seed;
+    int chunksW, chunksH;
+    int W, H;                   // in tiles
+    const unsigned char *kinds; // W * H, StoneVariant or KIND_FLOOR
+    BIOME_DATA biome_data;
+    Texture2D pathDirt;
+    tileChunk *slots;           // chunksW * chunksH, NULL when paged out
+    dynarray resident;
+    dynarray spare;             // evicted chunks waiting to be reused
+    unsigned clock;             // bumped by mapStreamAround
+    unsigned epoch;             // bumped by every eviction
+};
+
+static rect chunkRect(tileChunk c, int x, int y){
+    return &c->rects[(y - c->cy * CHUNK_SIZE) * CHUNK_SIZE + (x - c->cx * CHUNK_SIZE)];
 }
 
-bool canPlaceProperty(hash map, Texture2D prop, int x, int y) {
+static bool canPlaceProperty(tileChunk c, Texture2D prop, int x, int y) {
     // if (!prop) return false;
 
     int w = (prop.width  + TILE_SIZE - 1) / TILE_SIZE;
@@ -513,14 +503,14 @@ bool canPlaceProperty(hash map, Texture2D prop, int x, int y) {
     // printf("%d, %d", prop.width, prop.height);
     for (int dy = 0; dy < h; dy++) {
         for (int dx = 0; dx < w; dx++) {
-            char buffer[32];
             int nx = x + dx;
             int ny = y + dy;
 
-            snprintf(buffer, sizeof(buffer), "%d:%d", nx, ny);
-            rect r = hashFind(map, buffer);
+            // keep props inside the chunk they start in
+            if (nx / CHUNK_SIZE != c->cx || ny / CHUNK_SIZE != c->cy) return false;
+
+            rect r = chunkRect(c, nx, ny);
 
-            if (!r) return false; // out of bounds
             if (r->tileType != STONE_MIDDLE) return false;
             if (r->offGridType != -1) return false; // already occupied
         }
@@ -528,51 +518,21 @@ bool canPlaceProperty(hash map, Texture2D prop, int x, int y) {
     return true;
 }
 
-void offgridTileFree(DA_ELEMENT el){
-    offgridTile o = (offgridTile) el;
-    // UnloadTexture(o->texture);
-    free(o);
-}
-
-void placeProperty(hash map, hash offgridTiles, Texture2D prop, int index, int x, int y) {
+static void placeProperty(tileChunk c, Texture2D prop, int index, int x, int y) {
     int w = (prop.width  + TILE_SIZE - 1) / TILE_SIZE;
     int h = (prop.height + TILE_SIZE - 1) / TILE_SIZE;
 
     for (int dy = 0; dy < h; dy++) {
         for (int dx = 0; dx < w; dx++) {
-            char buffer[32];
-            snprintf(buffer, sizeof(buffer), "%d:%d", x + dx, y + dy);
-            rect r = hashFind(map, buffer);
-            if (r) {
-                r->offGridType = index;
-            }
+            chunkRect(c, x + dx, y + dy)->offGridType = index;
         }
     }
 
-    char buffer[22];
-    sprintf(buffer, "%d:%d", x / CHUNK_SIZE, y / CHUNK_SIZE);
-    dynarray tiles; 
-
-    offgridTile o = malloc(sizeof(struct offgridTile));
+    offgridTile o = arenaAlloc(c->a, sizeof(struct offgridTile));
     o->texture = prop;
     o->x       = x * TILE_SIZE; 
     o->y       = y * TILE_SIZE; 
-
-    if (hashFind(offgridTiles, buffer) == NULL){
-        dynarray arr = create_dynarray(&offgridTileFree, NULL);
-        hashSet(offgridTiles, buffer, arr);
-    }
-
-    if ((tiles = hashFind(offgridTiles, buffer)) != NULL){
-        // Just add the tile to the thing
-        add_dynarray(tiles, o);
-    }
-
-}
-
-static void enemyHashFree(hashvalue val){
-    dynarray enemy = (dynarray) val;
-    free_dynarray(enemy);
+    add_dynarray(c->offgrids, o);
 }
 
 static void computerHashFree(hashvalue val){
@@ -580,241 +540,771 @@ static void computerHashFree(hashvalue val){
     free_dynarray(computers);
 }
 
-static void npcAdd(int x, int y, mapData data){
-    NPC npc = npcCreate(
-        x * TILE_SIZE,
-        y * TILE_SIZE,
-        15,
-        15
-    );
-    char buffer[22];
-    sprintf(buffer, "%d:%d", x / CHUNK_SIZE, y / CHUNK_SIZE);
-    dynarray npcArr;
-    if (hashFind(data.npcs, buffer) == NULL){
-        hashSet(data.npcs, buffer, create_dynarray(NULL, NULL));
+// NPCs placed while a chunk's props are laid out, packed into the
+// chunk's npcGroup once the count is known
+typedef struct npcSpawnList{
+    npcSpawn *items;
+    int count, cap;
+} npcSpawnList;
+
+static void npcAdd(npcSpawnList *spawns, int x, int y, rng *r){
+    if (spawns->count == spawns->cap){
+        spawns->cap = spawns->cap ? spawns->cap * 2 : 16;
+        spawns->items = realloc(spawns->items, spawns->cap * sizeof(npcSpawn));
+        assert(spawns->items != NULL);
     }
-    if ((npcArr = hashFind(data.npcs, buffer)) != NULL){
-        add_dynarray(npcArr, npc);
+    spawns->items[spawns->count++] = npcSpawnRoll(r, x * TILE_SIZE, y * TILE_SIZE);
+}
+
+// A chunk's list only goes into the level hash if it has anything in it
+static void adoptChunkList(hash h, const char *key, dynarray list){
+    if (list->len > 0){
+        hashSet(h, (hashkey) key, list);
+    }
+    else{
+        free_dynarray(list);
     }
 }
 
-mapData mapCreate(hash offgridTiles, BIOME_DATA biome_data, Texture2D pathDirt, int level) {
-    LevelConfig config = LevelConfigFromLevel(level);
-    int WORLD_W = config.worldW;
-    int WORLD_H = config.worldH;
-   mapData data; 
-   data.map = hashCreate(&tilesPrint, &tilesFree, NULL);
+// Job: one pass over a chunk's rows of the carved grid, turning each
+// tile into its final kind (a StoneVariant or KIND_FLOOR) via stoneForMask.
+static void autotileChunkJob(void *ctx, int i){
+    worldGen *g = ctx;
+    chunkGen *c = &g->chunks[i];
+    int W = g->W, H = g->H;
+    int x0 = c->cx * CHUNK_SIZE, x1 = x0 + CHUNK_SIZE;
+
+    for (int y = c->cy * CHUNK_SIZE; y < (c->cy + 1) * CHUNK_SIZE; y++){
+        const TILES *cur  = g->world + y * W;
+        const TILES *up   = (y > 0)     ? cur - W : NULL;
+        const TILES *down = (y < H - 1) ? cur + W : NULL;
+        unsigned char *out = g->kinds + y * W;
+
+        for (int x = x0; x < x1; x++){
+            if (cur[x] != STONE){
+                out[x] = KIND_FLOOR;
+                continue;
+            }
+            int mask = (up   && up[x]   == DIRT)
+                     | (down && down[x] == DIRT) << 1
+                     | (x > 0     && cur[x-1] == DIRT) << 2
+                     | (x < W - 1 && cur[x+1] == DIRT) << 3;
+            out[x] = stoneForMask[mask];
+        }
+    }
+}
 
-   int GAME_WIDTH = WORLD_W * CHUNK_SIZE;
-   int GAME_HEIGHT = WORLD_H * CHUNK_SIZE;
-   TILES mappy[GAME_HEIGHT][GAME_WIDTH];
-   srand(time(NULL));
-   // generatePuzzleMap(mappy);
-   data.enemies = hashCreate(NULL, &enemyHashFree, NULL);
-   data.computers = hashCreate(NULL, &computerHashFree, NULL);
-   data.npcs = hashCreate(NULL, NULL, NULL);
-   data.noOfComputers = 0; 
-  generateWorld(&mappy[0][0], data.enemies, data.computers, &data.noOfComputers, WORLD_W, WORLD_H, config);
-
-   for (int y = 0; y < GAME_HEIGHT; y++){
-     for (int x = 0; x < GAME_WIDTH; x++){
-       rect r = malloc(sizeof(struct rect));
-       r->rectange = (Rectangle){ x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE };
-      r->tile = mappy[y][x];
-       r->offGridType = -1;
-
-      r->node = malloc(sizeof(struct pathNode));
-      r->node->x = x;
-      r->node->y = y;
-      r->node->isWalkable = (mappy[y][x] == DIRT);
-      r->node->gCost = INT_MAX;
-      r->node->hCost = 0;
-      r->node->fCost = 0;
-      r->node->prev = NULL;
-      
-      if (mappy[y][x] == STONE){
-        r->tileType = chooseStoneVariant(&mappy[0][0], x, y, GAME_WIDTH, GAME_HEIGHT);
-      }
-      else{
-         int var = GetRandomValue(0,3);
-         r->tileType = var;
-      }
-
-      char buffer[22];
-      sprintf(buffer, "%d:%d", x, y);
-      hashSet(data.map, buffer, r);
+// Build the rects and path nodes of one chunk from the finished kinds.
+// Only reads kinds, so any number of chunks can be built at once.
+static void chunkTiles(struct tilemap *m, tileChunk c){
+    int W = m->W, H = m->H;
+
+    for (int y = c->cy * CHUNK_SIZE; y < (c->cy + 1) * CHUNK_SIZE; y++){
+        for (int x = c->cx * CHUNK_SIZE; x < (c->cx + 1) * CHUNK_SIZE; x++){
+            int idx = y * W + x;
+            int local = (y - c->cy * CHUNK_SIZE) * CHUNK_SIZE + (x - c->cx * CHUNK_SIZE);
+            rect r = &c->rects[local];
+            pathNode n = &c->nodes[local];
+            int kind = m->kinds[idx];
+
+            r->rectange = (Rectangle){ x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE };
+            r->tile = (kind == KIND_FLOOR) ? DIRT : STONE;
+            r->offGridType = -1;
+            r->node = n;
+
+            n->x = x;
+            n->y = y;
+            n->isWalkable = (kind == KIND_FLOOR);
+            n->gCost = INT_MAX;
+            n->hCost = 0;
+            n->fCost = 0;
+            n->prev = NULL;
+
+            if (kind == KIND_FLOOR){
+                r->tileType = rngHash(m->seed, x, y) & 3;
+                continue;
+            }
+
+            r->tileType = kind;
+            if (y + 1 < H){
+                int below = m->kinds[idx + W];
+                if (below != KIND_FLOOR && stoneAbove[below] >= 0) r->tileType = stoneAbove[below];
+            }
+        }
     }
-  }
+}
 
-  // cleanup 
-  // remove tiles that have dirt on (top and bottom) or (left and right)
-  for (int y = 1; y < GAME_HEIGHT - 1; y++){
-    for (int x = 1; x < GAME_WIDTH - 1; x++){
-        char buffer[22]; 
-        sprintf(buffer, "%d:%d", x - 1, y);
-        rect rLeft = hashFind(data.map, buffer);
+// Offgrid props and the NPCs walking the paths between them. Props never
+// leave their chunk (see canPlaceProperty) and draw from the chunk's own
+// stream, so a rebuilt chunk gets the same props back.
+static void chunkProps(struct tilemap *m, tileChunk c, npcSpawnList *spawns){
+    rng pr;
+    rngSeed(&pr, m->seed, STREAM_PROPS + c->cy * m->chunksW + c->cx);
 
-        sprintf(buffer, "%d:%d", x + 1, y);
-        rect rRight = hashFind(data.map, buffer);
+    for (int y = c->cy * CHUNK_SIZE; y < (c->cy + 1) * CHUNK_SIZE; y++){
+        for (int x = c->cx * CHUNK_SIZE; x < (c->cx + 1) * CHUNK_SIZE; x++){
+            rect r = chunkRect(c, x, y);
 
-        sprintf(buffer, "%d:%d", x, y - 1);
-        rect rAbove = hashFind(data.map, buffer);
+            if (r->tileType == STONE_MIDDLE){
 
-        sprintf(buffer, "%d:%d", x, y + 1);
-        rect rDown = hashFind(data.map, buffer);
+                // float pathNoise = noise2d(x * 0.03f, y * 0.03f);
+                float nx = x * 0.02f;
+                float ny = y * 0.02f;
 
-        sprintf(buffer, "%d:%d", x, y);
-        rect rCurr = hashFind(data.map, buffer);
+                // Base noise, smooth
+                float base = noise2d(nx, ny);
 
-        bool delete = false;
-        if (rCurr->tile == STONE){
-            if (rLeft->tile == DIRT && rRight->tile == DIRT){
-                delete = true;
-            }
+                // Stretch it into stripes (like ridges/valleys)
+                float stripe = sinf(base * 6.28f * 2.0f); // 2.0f = density of paths
+
+                // Normalize to 0..1
+                stripe = (stripe + 1.0f) * 0.5f;
+                float hStripe = sinf(noise2d(nx, ny) * 6.28f * 1.5f);
+                float vStripe = sinf(noise2d(nx + 100, ny + 100) * 6.28f * 1.5f);
+
+                hStripe = fabsf(hStripe);
+                vStripe = fabsf(vStripe);
+
+
+                float areaNoise = noise2d(x * 0.02f, y * 0.02f);
+                int areaType; 
+
+                if (areaNoise < 0.33f) areaType = TOWN;
+                else if (areaNoise < 0.66f) areaType = FOREST;
+                else areaType = VILLAGE;
+
+                float propNoise = noise2d(x * 0.1f, y * 0.1f);
+                int index; 
+                Texture2D chosen; 
+
+                switch (areaType)
+                {
+                case TOWN:
+                    // index = (int) (propNoise * (m->biome_data->size_of_texs[TOWN])) % m->biome_data->size_of_texs[TOWN];
+
+                    if (hStripe < 0.2f || vStripe < 0.2f){
+                        if (canPlaceProperty(c, m->pathDirt, x, y)){
+                            placeProperty(c, m->pathDirt, 100, x, y);
+                            // Add NPC
+                            if (rngRange(&pr, 1, 100) < 20)
+                                npcAdd(spawns, x, y, &pr);
+                        }
+                
+                    }
+                    else{
+                        index = rngRange(&pr, 0, m->biome_data->size_of_texs[TOWN] - 1);
+                        chosen = m->biome_data->texs[TOWN][index];
+                        if (canPlaceProperty(c, chosen, x, y)){
+                            placeProperty(c, chosen, index, x, y);
+                        }
+                    }
+                    break;
+                case FOREST:
+                    // index = (int) (propNoise * (m->biome_data->size_of_texs[FOREST])) % m->biome_data->size_of_texs[FOREST];
+                    index = rngRange(&pr, 0, m->biome_data->size_of_texs[FOREST] - 1);
+                    chosen = m->biome_data->texs[FOREST][index];
+                    if (canPlaceProperty(c, chosen, x, y)){
+                        placeProperty(c, chosen, index, x, y);
+                    }
+                    break;
+                case VILLAGE:
+                    // index = (int) (propNoise * (m->biome_data->size_of_texs[VILLAGE])) % m->biome_data->size_of_texs[VILLAGE];
+
+                    if (hStripe < 0.2f || vStripe < 0.2f){
+                        if (canPlaceProperty(c, m->pathDirt, x, y)){
+                            placeProperty(c, m->pathDirt, 100, x, y);
+                            // Add NPC
+                            if (rngRange(&pr, 1, 100) < 20)
+                                npcAdd(spawns, x, y, &pr);
+                        }
+                    }
+                    else{
+                        index = rngRange(&pr, 0, m->biome_data->size_of_texs[VILLAGE] - 1);
+                        chosen = m->biome_data->texs[VILLAGE][index];
+                        if (canPlaceProperty(c, chosen, x, y)){
+                            placeProperty(c, chosen, index, x, y);
+                        }
+                    }   
+                    break;
+                default:
+                    break;
+                }
 
-            if (rAbove->tile == DIRT && rDown->tile == DIRT){
-                delete = true;
             }
         }
+    }
+}
 
-        if (delete){
-            rCurr->tile = DIRT;
-            rCurr->tileType = GetRandomValue(0,3);
-        }
+static void chunkBuild(struct tilemap *m, tileChunk c){
+    c->a = arenaCreate(CHUNK_ARENA_BLOCK);
+    c->offgrids = create_dynarray(NULL, NULL);
+    chunkTiles(m, c);
+    npcSpawnList spawns = {0};
+    chunkProps(m, c, &spawns);
+    npcGroupInit(&c->npcs, c->a, spawns.items, spawns.count);
+    free(spawns.items);
+}
+
+typedef struct chunkBatch{
+    struct tilemap *m;
+    tileChunk *chunks;
+} chunkBatch;
+
+// Job: build one freshly paged in chunk. Chunks never share memory and
+// the tilemap is only read, so the batch can run in parallel.
+static void chunkBuildJob(void *ctx, int i){
+    chunkBatch *b = ctx;
+    chunkBuild(b->m, b->chunks[i]);
+}
+
+static tileChunk chunkTake(tilemap m, int cx, int cy){
+    tileChunk c;
+    if (m->spare->len > 0){
+        c = m->spare->data[m->spare->len - 1];
+        remove_dynarray(m->spare, m->spare->len - 1);
     }
-  }
+    else{
+        c = malloc(sizeof(struct tileChunk));
+        assert(c != NULL);
+    }
+    c->cx = cx;
+    c->cy = cy;
+    c->lastUsed = m->clock;
+    return c;
+}
 
-  for (int y = 1; y < GAME_HEIGHT; y++) {   // start at 1 so y-1 is valid
-    for (int x = 0; x < GAME_WIDTH; x++) {
-        
-        char buffer[22];
-        sprintf(buffer, "%d:%d", x, y-1);
-        rect rAbove = hashFind(data.map, buffer);
+static void chunkInstall(tilemap m, tileChunk c){
+    m->slots[c->cy * m->chunksW + c->cx] = c;
+    add_dynarray(m->resident, c);
+}
 
-        sprintf(buffer, "%d:%d", x, y);
-        rect rCurr = hashFind(data.map, buffer);
+static void chunkRelease(tileChunk c){
+    free_dynarray(c->offgrids);
+    arenaFree(c->a);
+}
 
-        if (rCurr->tile == STONE && rCurr->tileType == STONE_BOTTOM){
-            if (rAbove->tile == STONE){
-                rAbove->tileType = STONE_BOTTOM_1;
-            }
-        }
+static void chunkEvict(tilemap m, int i){
+    tileChunk c = m->resident->data[i];
+    remove_dynarray(m->resident, i);
+    m->slots[c->cy * m->chunksW + c->cx] = NULL;
+    chunkRelease(c);
+    if (m->spare->len < MAP_SPARE_CHUNKS) add_dynarray(m->spare, c);
+    else free(c);
+    m->epoch++;
+}
 
-        if (rCurr->tile == STONE && rCurr->tileType == STONE_BL){
-            if (rAbove->tile == STONE){
-                rAbove->tileType = STONE_BL_1;
-            }
+// Chunk (cx, cy), built on the spot if it is paged out. Never evicts, so
+// rects handed out earlier in the frame stay valid. Only safe from several
+// threads for chunks mapStreamAround already touched this frame, which
+// are resident and not written again.
+static tileChunk chunkAt(tilemap m, int cx, int cy){
+    tileChunk c = m->slots[cy * m->chunksW + cx];
+    if (!c){
+        c = chunkTake(m, cx, cy);
+        chunkBuild(m, c);
+        chunkInstall(m, c);
+    }
+    if (c->lastUsed != m->clock) c->lastUsed = m->clock;
+    return c;
+}
+
+rect mapGetRecAt(tilemap map, int x, int y){
+    if ((unsigned)x >= (unsigned)map->W || (unsigned)y >= (unsigned)map->H) return NULL;
+    tileChunk c = chunkAt(map, x / CHUNK_SIZE, y / CHUNK_SIZE);
+    return &c->rects[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE];
+}
+
+void mapStreamAround(tilemap map, int cx, int cy){
+    map->clock++;
+
+    // the room and its neighbours are built together, off the main thread
+    tileChunk fresh[9];
+    int n = 0;
+    for (int y = cy - 1; y <= cy + 1; y++){
+        for (int x = cx - 1; x <= cx + 1; x++){
+            if (x < 0 || y < 0 || x >= map->chunksW || y >= map->chunksH) continue;
+            tileChunk c = map->slots[y * map->chunksW + x];
+            if (c) c->lastUsed = map->clock;
+            else fresh[n++] = chunkTake(map, x, y);
         }
+    }
+    if (n > 0){
+        chunkBatch b = { map, fresh };
+        jobsParallelFor(n, &chunkBuildJob, &b);
+        for (int i = 0; i < n; i++) chunkInstall(map, fresh[i]);
+    }
 
-        if (rCurr->tile == STONE && rCurr->tileType == STONE_BR){
-            if (rAbove->tile == STONE){
-                rAbove->tileType = STONE_BR_1;
+    // drop the least recently used chunks, never one touched this frame
+    while (map->resident->len > MAP_RESIDENT_CHUNKS){
+        int oldest = -1;
+        unsigned oldestUsed = map->clock;
+        for (int i = 0; i < map->resident->len; i++){
+            tileChunk c = map->resident->data[i];
+            if (c->lastUsed < oldestUsed){
+                oldest = i;
+                oldestUsed = c->lastUsed;
             }
         }
-        
+        if (oldest < 0) break;
+        chunkEvict(map, oldest);
     }
-  }
+}
 
-  // Placing offgrid stuff 
+unsigned mapEpoch(tilemap map){
+    return map->epoch;
+}
 
-  for (int y = 0; y < GAME_HEIGHT; y++){
-    for (int x = 0; x < GAME_WIDTH; x++){
-        char buffer[22];
-        sprintf(buffer, "%d:%d", x, y);
-        rect r = hashFind(data.map, buffer);
+dynarray mapChunkOffgrids(tilemap map, int cx, int cy){
+    if (cx < 0 || cy < 0 || cx >= map->chunksW || cy >= map->chunksH) return NULL;
+    return chunkAt(map, cx, cy)->offgrids;
+}
 
-        if (r->tileType == STONE_MIDDLE){
+npcGroup *mapChunkNpcs(tilemap map, int cx, int cy){
+    if (cx < 0 || cy < 0 || cx >= map->chunksW || cy >= map->chunksH) return NULL;
+    return &chunkAt(map, cx, cy)->npcs;
+}
 
-            // float pathNoise = noise2d(x * 0.03f, y * 0.03f);
-            float nx = x * 0.02f;
-            float ny = y * 0.02f;
+static tilemap tilemapCreate(arena level, uint64_t seed, int chunksW, int chunksH,
+                             const unsigned char *kinds, BIOME_DATA biome_data, Texture2D pathDirt){
+    tilemap m = arenaAlloc(level, sizeof(struct tilemap));
+    m->seed = seed;
+    m->chunksW = chunksW;
+    m->chunksH = chunksH;
+    m->W = chunksW * CHUNK_SIZE;
+    m->H = chunksH * CHUNK_SIZE;
+    m->kinds = kinds;
+    m->biome_data = biome_data;
+    m->pathDirt = pathDirt;
+    m->slots = arenaCalloc(level, chunksW * chunksH, sizeof(tileChunk));
+    m->resident = create_dynarray(NULL, NULL);
+    m->spare = create_dynarray(NULL, NULL);
+    m->clock = 0;
+    m->epoch = 0;
+    return m;
+}
 
-            // Base noise, smooth
-            float base = noise2d(nx, ny);
+static void tilemapFree(tilemap map){
+    for (int i = 0; i < map->resident->len; i++){
+        tileChunk c = map->resident->data[i];
+        chunkRelease(c);
+        free(c);
+    }
+    for (int i = 0; i < map->spare->len; i++) free(map->spare->data[i]);
+    free_dynarray(map->resident);
+    free_dynarray(map->spare);
+}
 
-            // Stretch it into stripes (like ridges/valleys)
-            float stripe = sinf(base * 6.28f * 2.0f); // 2.0f = density of paths
+#define LEVEL_ARENA_BLOCK (256 * 1024)
 
-            // Normalize to 0..1
-            stripe = (stripe + 1.0f) * 0.5f;
-            float hStripe = sinf(noise2d(nx, ny) * 6.28f * 1.5f);
-            float vStripe = sinf(noise2d(nx + 100, ny + 100) * 6.28f * 1.5f);
+uint64_t mapLevelSeed(uint64_t worldSeed, int level){
+  rng r;
+  rngSeed(&r, worldSeed, (uint64_t)level);
+  return ((uint64_t)rngNext(&r) << 32) | rngNext(&r);
+}
 
-            hStripe = fabsf(hStripe);
-            vStripe = fabsf(vStripe);
+// Pure CPU work: touches no GL state and no shared RNG, so it is safe to
+// run on the level loader thread. The same seed always builds the same level.
+//
+// Chunks are independent apart from the corridors between them, so the
+// work runs as: carve chunks (parallel) -> stitch borders -> autotile
+// (parallel) -> hand chunk results to the level. Tiles, props and NPCs are
+// left to the tile map, which builds them a chunk at a time on demand.
+mapData mapCreate(BIOME_DATA biome_data, Texture2D pathDirt, int level, uint64_t seed) {
+    rng rnd;
+    rngSeed(&rnd, seed, STREAM_LEVEL);
+    LevelConfig config = LevelConfigFromLevel(level, &rnd);
+    int WORLD_W = config.worldW;
+    int WORLD_H = config.worldH;
+   mapData data; 
+   data.seed = seed;
+   data.level = arenaCreate(LEVEL_ARENA_BLOCK);
 
+   int GAME_WIDTH = WORLD_W * CHUNK_SIZE;
+   int GAME_HEIGHT = WORLD_H * CHUNK_SIZE;
+   int total = GAME_WIDTH * GAME_HEIGHT;
+   // the carved grid is only needed until autotiling is done
+   TILES *mappy = malloc((size_t)total * sizeof(TILES));
+   assert(mappy != NULL);
+   unsigned char *kinds = arenaAlloc(data.level, (size_t)total);
+   data.computers = hashCreate(NULL, &computerHashFree, NULL);
+   data.noOfComputers = 0; 
+   data.width = GAME_WIDTH;
+   data.height = GAME_HEIGHT;
+
+   int nChunks = WORLD_W * WORLD_H;
+   chunkGen chunks[nChunks];
+   for (int i = 0; i < nChunks; i++){
+     chunks[i].cx = i % WORLD_W;
+     chunks[i].cy = i / WORLD_W;
+   }
+
+   worldGen g = {
+     .seed = seed,
+     .config = config,
+     .chunksW = WORLD_W,
+     .chunksH = WORLD_H,
+     .W = GAME_WIDTH,
+     .H = GAME_HEIGHT,
+     .world = mappy,
+     .kinds = kinds,
+     .chunks = chunks,
+   };
+
+  jobsParallelFor(nChunks, &carveChunkJob, &g);
+  stitchChunks(&g);
+  jobsParallelFor(nChunks, &autotileChunkJob, &g);
+  free(mappy);
+
+  // chunk i is room (i % WORLD_W, i / WORLD_W), the store's room order
+  int roomCounts[nChunks];
+  for (int i = 0; i < nChunks; i++)
+    roomCounts[i] = chunks[i].enemyCount;
+  data.enemies = enemyStoreCreate(data.level, WORLD_W, WORLD_H, roomCounts);
+
+  for (int i = 0; i < nChunks; i++){
+    chunkGen *c = &chunks[i];
+    char buffer[22];
+    sprintf(buffer, "%d:%d", c->cx, c->cy);
+    data.noOfComputers += c->computers->len;
+    for (int k = 0; k < c->enemyCount; k++)
+      enemyStoreAdd(data.enemies, c->cx, c->cy, c->enemies[k]);
+    adoptChunkList(data.computers, buffer, c->computers);
+    arenaAbsorb(data.level, c->a);
+  }
 
-            float areaNoise = noise2d(x * 0.02f, y * 0.02f);
-            int areaType; 
+  tilemap m = tilemapCreate(data.level, seed, WORLD_W, WORLD_H, kinds, biome_data, pathDirt);
+  data.map = m;
+  data.file = NULL;
+  data.fileSize = 0;
 
-            if (areaNoise < 0.33f) areaType = TOWN;
-            else if (areaNoise < 0.66f) areaType = FOREST;
-            else areaType = VILLAGE;
+  // packed y * width + x index of every walkable tile, for bird respawns
+  data.walkableCount = 0;
+  for (int i = 0; i < total; i++)
+    if (kinds[i] == KIND_FLOOR) data.walkableCount++;
+  data.walkable = arenaAlloc(data.level, (data.walkableCount > 0 ? data.walkableCount : 1) * sizeof(int));
+  int n = 0;
+  for (int i = 0; i < total; i++)
+    if (kinds[i] == KIND_FLOOR) data.walkable[n++] = i;
 
-            float propNoise = noise2d(x * 0.1f, y * 0.1f);
-            int index; 
-            Texture2D chosen; 
+  // page in the start room here so the first frame does not build it
+  mapStreamAround(m, 0, 0);
+  data.spawn = mapFindSpawnTopLeft(data.map);
 
-            switch (areaType)
-            {
-            case TOWN:
-                // index = (int) (propNoise * (biome_data->size_of_texs[TOWN])) % biome_data->size_of_texs[TOWN];
+  return data; 
+}
 
-                if (hStripe < 0.2f || vStripe < 0.2f){
-                    if (canPlaceProperty(data.map, pathDirt, x, y)){
-                        placeProperty(data.map, offgridTiles, pathDirt, 100, x, y);
-                        // Add NPC
-                        if (GetRandomValue(1,100) < 20)
-                            npcAdd(x, y, data);
-                    }
-                    
-                }
-                else{
-                    index = GetRandomValue(0, biome_data->size_of_texs[TOWN] - 1);
-                    chosen = biome_data->texs[TOWN][index];
-                    if (canPlaceProperty(data.map, chosen, x, y)){
-                        placeProperty(data.map, offgridTiles, chosen, index, x, y);
-                    }
-                }
-                break;
-            case FOREST:
-                // index = (int) (propNoise * (biome_data->size_of_texs[FOREST])) % biome_data->size_of_texs[FOREST];
-                index = GetRandomValue(0, biome_data->size_of_texs[FOREST] - 1);
-                chosen = biome_data->texs[FOREST][index];
-                if (canPlaceProperty(data.map, chosen, x, y)){
-                    placeProperty(data.map, offgridTiles, chosen, index, x, y);
-                }
-                break;
-            case VILLAGE:
-                // index = (int) (propNoise * (biome_data->size_of_texs[VILLAGE])) % biome_data->size_of_texs[VILLAGE];
-
-                if (hStripe < 0.2f || vStripe < 0.2f){
-                    if (canPlaceProperty(data.map, pathDirt, x, y)){
-                        placeProperty(data.map, offgridTiles, pathDirt, 100, x, y);
-                        // Add NPC
-                        if (GetRandomValue(1,100) < 20)
-                            npcAdd(x, y, data);
-                    }
-                }
-                else{
-                    index = GetRandomValue(0, biome_data->size_of_texs[VILLAGE] - 1);
-                    chosen = biome_data->texs[VILLAGE][index];
-                    if (canPlaceProperty(data.map, chosen, x, y)){
-                        placeProperty(data.map, offgridTiles, chosen, index, x, y);
-                    }
-                }   
-                break;
-            default:
-                break;
+// ------------ level files -------------
+// A saved level is one flat block in native byte order: header, kinds
+// grid, walkable list, computers, enemies. Rects, floor and prop variants
+// and NPCs all follow from kinds and the seed, so loading is a size check
+// and pointing the tile map at the mapped kinds; nothing is parsed per tile.
+#define LEVEL_FILE_MAGIC    0x56594C56u     // "VLYV"
+#define LEVEL_FILE_VERSION  1
+#define LEVEL_FILE_MAX_CHUNKS 64            // per side, keeps the size math small
+
+typedef struct levelFileHeader{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t worldSeed;
+    uint64_t seed;
+    int32_t level;
+    int32_t chunksW, chunksH;
+    int32_t walkableCount;
+    int32_t computerCount;
+    int32_t enemyCount;
+    float spawnX, spawnY;
+} levelFileHeader;
+
+typedef struct levelFileComputer{
+    int32_t cx, cy;
+    float x, y;
+    int32_t amountLeftToHack;
+    int32_t hacked;
+} levelFileComputer;
+
+typedef struct levelFileEnemy{
+    int32_t cx, cy;
+    float x, y;
+    int32_t health;
+    int32_t staggerSlot;
+} levelFileEnemy;
+
+// Android links fopen to raylib's APK asset reader, so level files, which
+// live in internal storage there, are opened by descriptor instead
+static FILE *levelFileStream(const char *path, bool write){
+#if defined(PLATFORM_ANDROID)
+    int fd = write ? open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600) : open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    FILE *f = fdopen(fd, write ? "wb" : "rb");
+    if (!f) close(fd);
+    return f;
+#else
+    return fopen(path, write ? "wb" : "rb");
+#endif
+}
+
+static void *levelFileOpen(const char *path, size_t *size){
+#ifdef LEVEL_FILE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0){
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    *size = (size_t)st.st_size;
+    return p;
+#else
+    FILE *f = levelFileStream(path, false);
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (len <= 0){
+        fclose(f);
+        return NULL;
+    }
+    void *p = malloc((size_t)len);
+    assert(p != NULL);
+    if (fread(p, 1, (size_t)len, f) != (size_t)len){
+        free(p);
+        p = NULL;
+    }
+    fclose(f);
+    *size = (size_t)len;
+    return p;
+#endif
+}
+
+static void levelFileClose(void *p, size_t size){
+#ifdef LEVEL_FILE_MMAP
+    munmap(p, size);
+#else
+    (void)size;
+    free(p);
+#endif
+}
+
+static dynarray chunkListAt(hash h, int cx, int cy){
+    char buffer[22];
+    sprintf(buffer, "%d:%d", cx, cy);
+    return hashFind(h, buffer);
+}
+
+// The list for chunk (cx, cy), created on first use
+static dynarray chunkListFor(hash h, int cx, int cy, dynarray_freef fef){
+    dynarray list = chunkListAt(h, cx, cy);
+    if (!list){
+        char buffer[22];
+        sprintf(buffer, "%d:%d", cx, cy);
+        list = create_dynarray(fef, NULL);
+        hashSet(h, buffer, list);
+    }
+    return list;
+}
+
+int mapComputersHacked(mapData data){
+    int hacked = 0;
+    for (int cy = 0; cy < data.height / CHUNK_SIZE; cy++){
+        for (int cx = 0; cx < data.width / CHUNK_SIZE; cx++){
+            dynarray list = chunkListAt(data.computers, cx, cy);
+            for (int i = 0; list && i < list->len; i++){
+                Computer comp = list->data[i];
+                if (comp->hacked) hacked++;
             }
+        }
+    }
+    return hacked;
+}
 
+// Written next to path and renamed over it, so a kill mid-write leaves
+// the previous save intact.
+bool mapSave(const char *path, mapData data, uint64_t worldSeed, int level){
+    tilemap m = data.map;
+    levelFileHeader h = {
+        .magic = LEVEL_FILE_MAGIC,
+        .version = LEVEL_FILE_VERSION,
+        .worldSeed = worldSeed,
+        .seed = data.seed,
+        .level = level,
+        .chunksW = m->chunksW,
+        .chunksH = m->chunksH,
+        .walkableCount = data.walkableCount,
+        .computerCount = 0,
+        .enemyCount = 0,
+        .spawnX = data.spawn.x,
+        .spawnY = data.spawn.y,
+    };
+    for (int cy = 0; cy < m->chunksH; cy++){
+        for (int cx = 0; cx < m->chunksW; cx++){
+            dynarray list;
+            const enemyHandle *room;
+            if ((list = chunkListAt(data.computers, cx, cy)) != NULL) h.computerCount += list->len;
+            h.enemyCount += enemyRoom(data.enemies, cx, cy, &room);
         }
     }
-  }
 
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = levelFileStream(tmp, true);
+    if (!f){
+        TraceLog(LOG_WARNING, "Could not save the level: cannot create %s", tmp);
+        return false;
+    }
 
+    fwrite(&h, sizeof(h), 1, f);
+    fwrite(m->kinds, 1, (size_t)m->W * m->H, f);
+    fwrite(data.walkable, sizeof(int32_t), (size_t)data.walkableCount, f);
+    for (int cy = 0; cy < m->chunksH; cy++){
+        for (int cx = 0; cx < m->chunksW; cx++){
+            dynarray list = chunkListAt(data.computers, cx, cy);
+            for (int i = 0; list && i < list->len; i++){
+                Computer comp = list->data[i];
+                levelFileComputer rec = { cx, cy, comp->e->pos.x, comp->e->pos.y,
+                                          comp->amountLeftToHack, comp->hacked };
+                fwrite(&rec, sizeof(rec), 1, f);
+            }
+        }
+    }
+    for (int cy = 0; cy < m->chunksH; cy++){
+        for (int cx = 0; cx < m->chunksW; cx++){
+            const enemyHandle *room;
+            int count = enemyRoom(data.enemies, cx, cy, &room);
+            for (int i = 0; i < count; i++){
+                Enemy e = enemyGet(data.enemies, room[i]);
+                levelFileEnemy rec = { cx, cy, e->e->pos.x, e->e->pos.y, e->health, e->staggerSlot };
+                fwrite(&rec, sizeof(rec), 1, f);
+            }
+        }
+    }
 
-  return data; 
+    bool ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    if (!ok){
+        TraceLog(LOG_WARNING, "Could not save the level: writing %s failed", tmp);
+        remove(tmp);
+        return false;
+    }
+#if defined(_WIN32)
+    remove(path);   // rename does not replace on Windows
+#endif
+    if (rename(tmp, path) != 0){
+        TraceLog(LOG_WARNING, "Could not save the level: cannot replace %s", path);
+        remove(tmp);
+        return false;
+    }
+    return true;
+}
+
+// On success the level keeps the file mapped until mapFree: its kinds
+// and walkable list point straight into it.
+bool mapLoad(const char *path, BIOME_DATA biome_data, Texture2D pathDirt,
+             mapData *out, uint64_t *worldSeed, int *level){
+    size_t size = 0;
+    unsigned char *file = levelFileOpen(path, &size);
+    if (!file) return false;
+
+    const levelFileHeader *h = (const levelFileHeader *) file;
+    bool valid = size >= sizeof(*h)
+              && h->magic == LEVEL_FILE_MAGIC
+              && h->version == LEVEL_FILE_VERSION
+              && h->chunksW > 0 && h->chunksW <= LEVEL_FILE_MAX_CHUNKS
+              && h->chunksH > 0 && h->chunksH <= LEVEL_FILE_MAX_CHUNKS;
+    size_t tiles = valid ? (size_t)h->chunksW * h->chunksH * CHUNK_TILES : 0;
+    valid = valid
+         && h->walkableCount >= 0 && (size_t)h->walkableCount <= tiles
+         && h->computerCount >= 0 && (size_t)h->computerCount <= tiles
+         && h->enemyCount >= 0 && (size_t)h->enemyCount <= tiles
+         && size == sizeof(*h) + tiles
+                  + (size_t)h->walkableCount * sizeof(int32_t)
+                  + (size_t)h->computerCount * sizeof(levelFileComputer)
+                  + (size_t)h->enemyCount * sizeof(levelFileEnemy);
+    if (!valid){
+        TraceLog(LOG_WARNING, "Ignoring level file %s: wrong version or size", path);
+        levelFileClose(file, size);
+        return false;
+    }
+
+    const unsigned char *kinds = file + sizeof(*h);
+    const int32_t *walkable = (const int32_t *) (kinds + tiles);
+    const levelFileComputer *comps = (const levelFileComputer *) (walkable + h->walkableCount);
+    const levelFileEnemy *enemies = (const levelFileEnemy *) (comps + h->computerCount);
+    // The file is trusted as-is once loaded, so every index in it is checked here.
+    const char *bad = NULL;
+    for (size_t i = 0; i < tiles && !bad; i++){
+        if (kinds[i] != KIND_FLOOR && kinds[i] >= sizeof(stoneAbove)) bad = "unknown tile kind";
+    }
+    for (int i = 0; i < h->walkableCount && !bad; i++){
+        if (walkable[i] < 0 || (size_t)walkable[i] >= tiles || kinds[walkable[i]] != KIND_FLOOR)
+            bad = "walkable tile is not floor";
+    }
+    for (int i = 0; i < h->computerCount && !bad; i++){
+        if ((unsigned)comps[i].cx >= (unsigned)h->chunksW || (unsigned)comps[i].cy >= (unsigned)h->chunksH)
+            bad = "computer outside the map";
+    }
+    for (int i = 0; i < h->enemyCount && !bad; i++){
+        if ((unsigned)enemies[i].cx >= (unsigned)h->chunksW || (unsigned)enemies[i].cy >= (unsigned)h->chunksH)
+            bad = "enemy outside the map";
+    }
+    if (bad){
+        TraceLog(LOG_WARNING, "Ignoring level file %s: %s", path, bad);
+        levelFileClose(file, size);
+        return false;
+    }
+
+    mapData data;
+    data.seed = h->seed;
+    data.level = arenaCreate(LEVEL_ARENA_BLOCK);
+    data.computers = hashCreate(NULL, &computerHashFree, NULL);
+    data.noOfComputers = h->computerCount;
+    data.width = h->chunksW * CHUNK_SIZE;
+    data.height = h->chunksH * CHUNK_SIZE;
+    data.walkable = (int *) walkable;   // read only, like the rest of the mapping
+    data.walkableCount = h->walkableCount;
+    data.spawn = (Vector2){ h->spawnX, h->spawnY };
+    data.file = file;
+    data.fileSize = size;
+
+    for (int i = 0; i < h->computerCount; i++){
+        Computer comp = arenaAlloc(data.level, sizeof(struct Computer));
+        comp->e = entityCreateIn(data.level, comps[i].x, comps[i].y, 15, 15);
+        comp->hacked = comps[i].hacked != 0;
+        comp->amountLeftToHack = comps[i].amountLeftToHack;
+        add_dynarray(chunkListFor(data.computers, comps[i].cx, comps[i].cy, NULL), comp);
+    }
+
+    // fields the file does not keep come from the level stream, as in carveChunkJob
+    int roomCounts[h->chunksW * h->chunksH];
+    memset(roomCounts, 0, sizeof(roomCounts));
+    for (int i = 0; i < h->enemyCount; i++)
+        roomCounts[enemies[i].cy * h->chunksW + enemies[i].cx]++;
+    data.enemies = enemyStoreCreate(data.level, h->chunksW, h->chunksH, roomCounts);
+    rng r;
+    rngSeed(&r, h->seed, STREAM_LEVEL);
+    for (int i = 0; i < h->enemyCount; i++){
+        enemySpawn spawn = enemySpawnRoll(&r, enemies[i].x, enemies[i].y);
+        spawn.health = enemies[i].health;
+        spawn.staggerSlot = enemies[i].staggerSlot;
+        enemyStoreAdd(data.enemies, enemies[i].cx, enemies[i].cy, spawn);
+    }
+
+    data.map = tilemapCreate(data.level, h->seed, h->chunksW, h->chunksH, kinds, biome_data, pathDirt);
+    mapStreamAround(data.map, (int)(data.spawn.x / ROOM_SIZE), (int)(data.spawn.y / ROOM_SIZE));
+
+    *worldSeed = h->worldSeed;
+    *level = h->level;
+    *out = data;
+    return true;
+}
+
+// Centre of the i-th walkable tile in world space.
+Vector2 mapWalkableTileCenter(mapData data, int i){
+  int idx = data.walkable[i];
+  return (Vector2){ (idx % data.width) * TILE_SIZE + TILE_SIZE / 2.0f,
+                    (idx / data.width) * TILE_SIZE + TILE_SIZE / 2.0f };
 }
 
 void rectFree(DA_ELEMENT el){
@@ -845,17 +1335,15 @@ void rectFree(DA_ELEMENT el){
 // }
 
 
-int rectsAround(hash map, Vector2 player_pos, struct rect *outRects) {
+int rectsAround(tilemap map, Vector2 player_pos, struct rect *outRects) {
     int count = 0;
     int gx = ((int) player_pos.x) / TILE_SIZE;
     int gy = ((int) player_pos.y) / TILE_SIZE;
 
     for (int x = gx - 5; x <= gx + 5; x++) {
         for (int y = gy - 5; y <= gy + 5; y++) {
-            char buffer[22];
-            sprintf(buffer, "%d:%d", x, y);
             rect rec;
-            if ((rec = hashFind(map, buffer)) != NULL) {
+            if ((rec = mapGetRecAt(map, x, y)) != NULL) {
                 if (rec->tile == STONE && rec->offGridType != 100) {
                     if (count >= MAX_RECTS) break; // avoid overflow
                     outRects[count].tile = rec->tile;
@@ -869,6 +1357,116 @@ int rectsAround(hash map, Vector2 player_pos, struct rect *outRects) {
     return count; // number of rects filled
 }
 
+// Stone blocks sight unless a path is laid over it (offGridType 100, the
+// same tiles rectsAround lets you walk on). Off the map blocks too.
+static inline bool tileBlocksSight(rect r){
+    return !r || (r->tile == STONE && r->offGridType != 100);
+}
+
+bool mapBlocksSight(tilemap map, int x, int y){
+    return tileBlocksSight(mapGetRecAt(map, x, y));
+}
+
+// Grid DDA (Amanatides & Woo): walks every tile the segment crosses, in
+// order, so walls count at any range and the cost is the tiles crossed.
+// The tiles holding the two end points are not tested.
+bool mapLineOfSight(tilemap map, Vector2 from, Vector2 to) {
+    int x = (int)floorf(from.x / TILE_SIZE);
+    int y = (int)floorf(from.y / TILE_SIZE);
+    int tx = (int)floorf(to.x / TILE_SIZE);
+    int ty = (int)floorf(to.y / TILE_SIZE);
+
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    int stepX = dx > 0 ? 1 : -1;
+    int stepY = dy > 0 ? 1 : -1;
+
+    // ray parameter t in [0, 1] at the next vertical / horizontal grid line
+    float tMaxX = dx > 0 ? ((x + 1) * TILE_SIZE - from.x) / dx
+                : dx < 0 ? (x * TILE_SIZE - from.x) / dx : INFINITY;
+    float tMaxY = dy > 0 ? ((y + 1) * TILE_SIZE - from.y) / dy
+                : dy < 0 ? (y * TILE_SIZE - from.y) / dy : INFINITY;
+    float tDeltaX = dx != 0 ? fabsf(TILE_SIZE / dx) : INFINITY;
+    float tDeltaY = dy != 0 ? fabsf(TILE_SIZE / dy) : INFINITY;
+
+    for (int n = abs(tx - x) + abs(ty - y); n > 1; n--) {
+        if (tMaxX < tMaxY) {
+            x += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            y += stepY;
+            tMaxY += tDeltaY;
+        }
+        if (x == tx && y == ty) break;
+        if (tileBlocksSight(mapGetRecAt(map, x, y))) return false;
+    }
+    return true;
+}
+
+// Octant transforms for shadowcasting: (col, row) -> (col*xx + row*xy, col*yx + row*yy)
+static const int fovOctants[8][4] = {
+    { 1,  0,  0,  1}, { 0,  1,  1,  0}, { 0, -1,  1,  0}, {-1,  0,  0,  1},
+    {-1,  0,  0, -1}, { 0, -1, -1,  0}, { 0,  1, -1,  0}, { 1,  0,  0, -1}
+};
+
+#define FOV_BIT(rows, radius, x, y) (((rows)[(y) + (radius)] >> ((x) + (radius))) & 1u)
+
+// One octant of recursive shadowcasting (Bergstrom). Rows are scanned
+// outwards between the slopes start >= end; a run of walls splits the
+// scan, the part before it recursing one row further out.
+static void castOctant(const uint32_t *opaque, uint32_t *visible, int radius,
+                       int row, float start, float end, const int *t){
+    if (start < end) return;
+    float newStart = 0.0f;
+    for (int j = row; j <= radius; j++){
+        bool blocked = false;
+        for (int dx = -j; dx <= 0; dx++){
+            int dy = -j;
+            float leftSlope  = (dx - 0.5f) / (dy + 0.5f);
+            float rightSlope = (dx + 0.5f) / (dy - 0.5f);
+            if (start < rightSlope) continue;
+            if (end > leftSlope) break;
+
+            int x = dx * t[0] + dy * t[1];
+            int y = dx * t[2] + dy * t[3];
+            if (dx * dx + dy * dy <= radius * radius)
+                visible[y + radius] |= 1u << (x + radius);
+
+            bool wall = FOV_BIT(opaque, radius, x, y);
+            if (blocked){
+                if (wall){
+                    newStart = rightSlope;
+                    continue;
+                }
+                blocked = false;
+                start = newStart;
+            }
+            else if (wall && j < radius){
+                blocked = true;
+                castOctant(opaque, visible, radius, j + 1, start, leftSlope, t);
+                newStart = rightSlope;
+            }
+        }
+        if (blocked) break;
+    }
+}
+
+void mapFieldOfView(tilemap map, int ox, int oy, int radius, uint32_t *visible, uint32_t *opaque){
+    assert(radius <= MAP_FOV_MAX_RADIUS);
+    int size = 2 * radius + 1;
+    for (int r = 0; r < size; r++){
+        uint32_t bits = 0;
+        for (int c = 0; c < size; c++)
+            if (tileBlocksSight(mapGetRecAt(map, ox - radius + c, oy - radius + r))) bits |= 1u << c;
+        opaque[r] = bits;
+        visible[r] = 0;
+    }
+
+    visible[radius] |= 1u << radius;
+    for (int o = 0; o < 8; o++)
+        castOctant(opaque, visible, radius, 1, 1.0f, 0.0f, fovOctants[o]);
+}
+
 
 // ------------ batching cache -------------
 typedef struct RoomCache {
@@ -886,7 +1484,7 @@ static Rectangle GetCameraWorldBounds(Camera2D cam) {
 }
 
 
-void MapEnsureCache(hash map, Camera2D camera, Texture2D *tileMap, Texture2D *stoneMap, Texture2D *dirtMap) {
+void MapEnsureCache(tilemap map, Camera2D camera, Texture2D *tileMap, Texture2D *stoneMap, Texture2D *dirtMap) {
     const int PAD_TILES_X = 2, PAD_TILES_Y = 2;
 
     Rectangle view = GetCameraWorldBounds(camera);
@@ -921,18 +1519,17 @@ void MapEnsureCache(hash map, Camera2D camera, Texture2D *tileMap, Texture2D *st
         s_cache.tex = LoadRenderTexture(cacheW, cacheH);
     }
 
-    if (needResize || movedOutside) {
+    if (needResize || movedOutside || s_cache.dirty) {
+        s_cache.dirty = false;
         s_cache.worldRect = (Rectangle){ (float)cacheX, (float)cacheY, (float)cacheW, (float)cacheH };
 
         // IMPORTANT: draw cache with no camera, no nesting inside your main target
         BeginTextureMode(s_cache.tex);
             ClearBackground((Color) {0, 0, 0, 0}); // or BLANK, your choice
 
-            char key[32];
             for (int tx = minTileX; tx < maxTileX; tx++) {
                 for (int ty = minTileY; ty < maxTileY; ty++) {
-                    sprintf(key, "%d:%d", tx, ty);
-                    rect r = (rect)hashFind(map, key);   // <-- correct type!
+                    rect r = mapGetRecAt(map, tx, ty);
                     if (!r) continue;
 
                     int lx = tx * TILE_SIZE - cacheX;    // local coords in cache
@@ -961,6 +1558,11 @@ void MapEnsureCache(hash map, Camera2D camera, Texture2D *tileMap, Texture2D *st
     }
 }
 
+// The cached tiles belong to the previous map after a level swap.
+void MapInvalidateCache(void) {
+    s_cache.dirty = true;
+}
+
 void MapDrawCached(Camera2D camera) {
     if (!s_cache.tex.id) return;
 
@@ -985,6 +1587,13 @@ void MapDrawCached(Camera2D camera) {
 }
 
 
-void mapFree(hash map){
-  hashFree(map);
+// Tear down a level: the resident chunks go first, then the hashes, which
+// only own their containers; every enemy, computer and walkable index goes
+// with the level arena.
+void mapFree(mapData data){
+  tilemapFree(data.map);
+  enemyStoreRelease(data.enemies);
+  hashFree(data.computers);
+  arenaFree(data.level);
+  if (data.file) levelFileClose(data.file, data.fileSize);
 }
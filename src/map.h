@@ -4,6 +4,8 @@
 #include "raylib.h"
 #include "hash.h"
 #include "dynarray.h"
+#include "arena.h"
+#include "rng.h"
 
 
 #define TILE_SIZE 16 
@@ -87,12 +89,30 @@ struct Door{
 };
 typedef struct Door *Door;
 
+// The tiles of a level, paged in a chunk at a time around the player.
+// Only a bounded set of chunks keeps its rects, path nodes, props and NPCs
+// in memory; the rest is rebuilt from the level seed when it is next touched.
+typedef struct tilemap *tilemap;
+
+struct enemyStore;
+struct npcGroup;
+
+// Everything generated for one level. Enemies, computers, the walkable tile
+// list and the tile map's bookkeeping are allocated from `level` and
+// released together by mapFree.
 typedef struct{
-  hash map;
-  hash enemies; 
+  uint64_t seed;       // same seed, same level
+  arena level;
+  tilemap map;
+  struct enemyStore *enemies;   // see enemy.h
   hash computers;
-  hash npcs; 
   int noOfComputers; 
+  int width, height;   // in tiles
+  int *walkable;       // y * width + x of every DIRT tile
+  int walkableCount;
+  Vector2 spawn;       // player start, see mapFindSpawnTopLeft
+  void *file;          // level file mapped by mapLoad, NULL if generated
+  size_t fileSize;
 } mapData;
 
 struct offgrid{
@@ -109,17 +129,42 @@ struct offgridTile{
 };
 typedef struct offgridTile *offgridTile;
 
-mapData mapCreate(hash offgridTiles, BIOME_DATA biome_data, Texture2D pathDirt, int level);
+extern uint64_t mapLevelSeed(uint64_t worldSeed, int level);
+mapData mapCreate(BIOME_DATA biome_data, Texture2D pathDirt, int level, uint64_t seed);
 // extern void mapDraw(Camera2D camera);
 extern void MapDrawCached(Camera2D camera);
-void MapEnsureCache(hash map, Camera2D camera, Texture2D *tileMap, Texture2D *stoneMap, Texture2D *dirtMap);
+extern void MapInvalidateCache(void);
+void MapEnsureCache(tilemap map, Camera2D camera, Texture2D *tileMap, Texture2D *stoneMap, Texture2D *dirtMap);
 // extern dynarray rectsAround(hash map, Vector2 player_pos);
-extern int rectsAround(hash map, Vector2 player_pos, struct rect *outRects);
-extern void mapFree(hash map);
-extern rect mapGetRecAt(hash map, int x, int y);
+extern int rectsAround(tilemap map, Vector2 player_pos, struct rect *outRects);
+extern void mapFree(mapData data);
+extern Vector2 mapWalkableTileCenter(mapData data, int i);
+extern rect mapGetRecAt(tilemap map, int x, int y);
+// True for tiles that stop sight and light (walls, and anything off the map).
+extern bool mapBlocksSight(tilemap map, int x, int y);
+// True when no wall lies on the segment between two world positions.
+extern bool mapLineOfSight(tilemap map, Vector2 from, Vector2 to);
+// Field of view from tile (ox, oy) out to `radius` tiles by recursive
+// shadowcasting. Row r of `visible` and `opaque` is tile row oy - radius + r,
+// and bit c in it is tile column ox - radius + c.
+#define MAP_FOV_MAX_RADIUS 15
+extern void mapFieldOfView(tilemap map, int ox, int oy, int radius, uint32_t *visible, uint32_t *opaque);
+// Page in the chunks around room (cx, cy) and evict the least recently
+// used ones beyond the resident budget. Call once per frame.
+extern void mapStreamAround(tilemap map, int cx, int cy);
+// Bumped whenever a chunk is evicted: rects and path nodes fetched under
+// an older epoch may point at freed memory.
+extern unsigned mapEpoch(tilemap map);
+extern dynarray mapChunkOffgrids(tilemap map, int cx, int cy);
+extern struct npcGroup *mapChunkNpcs(tilemap map, int cx, int cy);
 // extern void generateRandomWalkerMap(TILES map[HEIGHT][WIDTH]);
 extern void printMap(TILES map[HEIGHT][WIDTH]);
 // extern Door getPlayerRoomDoor(dynarray doors, Vector2 playerPos);
-extern Vector2 mapFindSpawnTopLeft(hash map);
+extern Vector2 mapFindSpawnTopLeft(tilemap map);
+// Versioned flat level files, for resuming a run and for fixed benchmark levels
+extern bool mapSave(const char *path, mapData data, uint64_t worldSeed, int level);
+extern bool mapLoad(const char *path, BIOME_DATA biome_data, Texture2D pathDirt,
+                    mapData *out, uint64_t *worldSeed, int *level);
+extern int mapComputersHacked(mapData data);
 
 #endif
\ No newline at end of file
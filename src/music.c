@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#include "raylib.h"
+#include "assets.h"
+#include "music.h"
+#include "sfx.h"
+
+#if !defined(PLATFORM_WEB)
+#include <time.h>
+#include <pthread.h>
+#define MUSIC_THREADED
+#endif
+
+// QOA layout, see qoaformat.org: an 8 byte file header, then frames of up
+// to 256 slices of 20 samples per channel, each frame starting with the
+// LMS predictor state of every channel.
+#define QOA_MAGIC 0x716f6166u     // "qoaf"
+#define QOA_SLICE_LEN 20
+#define QOA_FRAME_LEN (QOA_SLICE_LEN * 256)
+#define QOA_MAX_CHANNELS 8
+
+// Interleaved output frames, a power of two; about 340ms at 48kHz
+#define MUSIC_RING_FRAMES 16384
+#define MUSIC_REFILL_MS 5
+
+typedef struct qoaLms{
+  int history[4];
+  int weights[4];
+} qoaLms;
+
+typedef struct musicTrack{
+  unsigned char *data;          // whole file, NULL when nothing plays
+  int size;
+  int pos;                      // byte offset of the next frame
+} musicTrack;
+
+typedef struct musicPlayer{
+  bool ready;
+  AudioStream stream;
+
+  // Single producer (the decoder), single consumer (the audio callback).
+  // head and tail count frames and wrap; only the producer moves head and
+  // only the consumer moves tail.
+  int16_t ring[MUSIC_RING_FRAMES * MUSIC_CHANNELS];
+  atomic_uint head, tail;
+  // Raised by the producer on a track change; the consumer drops what is
+  // buffered and lowers it, and the producer writes nothing until then.
+  atomic_int flush;
+
+  // Decoder side
+  musicTrack track;
+  int16_t frame[QOA_FRAME_LEN * MUSIC_CHANNELS];
+  int frameLen, frameRead;
+
+#ifdef MUSIC_THREADED
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  bool quit;
+  bool hasPending;
+  musicTrack pending;
+#endif
+} musicPlayer;
+
+static musicPlayer s_music = {0};
+static int s_dequant[16][8];
+
+static inline uint64_t readU64(const unsigned char *p){
+  return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) |
+         ((uint64_t)p[3] << 32) | ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+         ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+static void buildDequantTable(void){
+  static const double steps[8] = { 0.75, -0.75, 2.5, -2.5, 4.5, -4.5, 7.0, -7.0 };
+  for (int s = 0; s < 16; s++){
+    double scale = round(pow(s + 1, 2.75));
+    for (int q = 0; q < 8; q++) s_dequant[s][q] = (int)round(scale * steps[q]);
+  }
+}
+
+// Decodes the frame at t->pos into interleaved stereo and returns its
+// length in samples per channel, 0 at the end of the data or on a frame
+// this player cannot take.
+static int decodeFrame(musicTrack *t, int16_t *out){
+  if (t->size - t->pos < 8) return 0;
+  const unsigned char *p = t->data + t->pos;
+  uint64_t header = readU64(p);
+  int channels = (int)((header >> 56) & 0xff);
+  int rate = (int)((header >> 32) & 0xffffff);
+  int samples = (int)((header >> 16) & 0xffff);
+  int frameSize = (int)(header & 0xffff);
+  int slices = (samples + QOA_SLICE_LEN - 1) / QOA_SLICE_LEN;
+  if (channels < 1 || channels > QOA_MAX_CHANNELS || rate != MUSIC_SAMPLE_RATE ||
+      samples < 1 || samples > QOA_FRAME_LEN ||
+      frameSize != 8 + channels * 16 + slices * channels * 8 || frameSize > t->size - t->pos)
+    return 0;
+  p += 8;
+
+  qoaLms lms[QOA_MAX_CHANNELS];
+  for (int c = 0; c < channels; c++, p += 16){
+    uint64_t history = readU64(p), weights = readU64(p + 8);
+    for (int i = 0; i < 4; i++){
+      lms[c].history[i] = (int16_t)(history >> 48);
+      lms[c].weights[i] = (int16_t)(weights >> 48);
+      history <<= 16;
+      weights <<= 16;
+    }
+  }
+
+  for (int s = 0; s < samples; s += QOA_SLICE_LEN){
+    int end = s + QOA_SLICE_LEN < samples ? s + QOA_SLICE_LEN : samples;
+    for (int c = 0; c < channels; c++, p += 8){
+      uint64_t slice = readU64(p);
+      const int *dequant = s_dequant[(slice >> 60) & 0xf];
+      slice <<= 4;
+      qoaLms *l = &lms[c];
+      for (int i = s; i < end; i++, slice <<= 3){
+        int predicted = (l->weights[0] * l->history[0] + l->weights[1] * l->history[1] +
+                         l->weights[2] * l->history[2] + l->weights[3] * l->history[3]) >> 13;
+        int residual = dequant[(slice >> 61) & 0x7];
+        int sample = predicted + residual;
+        sample = sample < -32768 ? -32768 : (sample > 32767 ? 32767 : sample);
+
+        int delta = residual >> 4;
+        for (int k = 0; k < 4; k++) l->weights[k] += l->history[k] < 0 ? -delta : delta;
+        l->history[0] = l->history[1];
+        l->history[1] = l->history[2];
+        l->history[2] = l->history[3];
+        l->history[3] = sample;
+
+        // Mono plays on both sides, channels past the second are dropped
+        if (c < MUSIC_CHANNELS) out[i * MUSIC_CHANNELS + c] = (int16_t)sample;
+        if (channels == 1) out[i * MUSIC_CHANNELS + 1] = (int16_t)sample;
+      }
+    }
+  }
+  t->pos += frameSize;
+  return samples;
+}
+
+// Producer: tops the ring up from the current track, looping it. False
+// when nothing could be written.
+static bool fillRing(void){
+  musicPlayer *m = &s_music;
+  if (m->track.data == NULL || atomic_load_explicit(&m->flush, memory_order_acquire)) return false;
+
+  unsigned head = atomic_load_explicit(&m->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&m->tail, memory_order_acquire);
+  unsigned space = MUSIC_RING_FRAMES - (head - tail);
+  bool wrote = false;
+  while (space > 0){
+    if (m->frameRead == m->frameLen){
+      m->frameRead = 0;
+      m->frameLen = decodeFrame(&m->track, m->frame);
+      if (m->frameLen == 0){
+        // End of the track, or a bad frame: loop, unless even the first
+        // frame fails
+        if (m->track.pos == 8){
+          TraceLog(LOG_WARNING, "MUSIC: track is not 48kHz QOA, stopping");
+          UnloadFileData(m->track.data);
+          m->track = (musicTrack){0};
+          break;
+        }
+        m->track.pos = 8;
+        continue;
+      }
+    }
+    unsigned n = (unsigned)(m->frameLen - m->frameRead);
+    if (n > space) n = space;
+    for (unsigned i = 0; i < n; i++){
+      unsigned slot = ((head + i) & (MUSIC_RING_FRAMES - 1)) * MUSIC_CHANNELS;
+      const int16_t *src = &m->frame[(m->frameRead + i) * MUSIC_CHANNELS];
+      m->ring[slot] = src[0];
+      m->ring[slot + 1] = src[1];
+    }
+    m->frameRead += n;
+    head += n;
+    space -= n;
+    wrote = true;
+  }
+  atomic_store_explicit(&m->head, head, memory_order_release);
+  return wrote;
+}
+
+// Consumer, on the audio device's thread: never blocks, plays silence
+// when the ring runs dry, then lays the sound effects over the music.
+static void musicCallback(void *buffer, unsigned int frames){
+  musicPlayer *m = &s_music;
+  int16_t *out = buffer;
+
+#ifndef MUSIC_THREADED
+  fillRing();
+#endif
+
+  unsigned head = atomic_load_explicit(&m->head, memory_order_acquire);
+  unsigned tail = atomic_load_explicit(&m->tail, memory_order_relaxed);
+  if (atomic_load_explicit(&m->flush, memory_order_acquire)){
+    tail = head;
+    atomic_store_explicit(&m->tail, tail, memory_order_release);
+    atomic_store_explicit(&m->flush, 0, memory_order_release);
+  }
+
+  unsigned n = head - tail;
+  if (n > frames) n = frames;
+  for (unsigned i = 0; i < n; i++){
+    unsigned slot = ((tail + i) & (MUSIC_RING_FRAMES - 1)) * MUSIC_CHANNELS;
+    out[i * MUSIC_CHANNELS] = m->ring[slot];
+    out[i * MUSIC_CHANNELS + 1] = m->ring[slot + 1];
+  }
+  memset(out + n * MUSIC_CHANNELS, 0, (frames - n) * MUSIC_CHANNELS * sizeof(int16_t));
+  atomic_store_explicit(&m->tail, tail + n, memory_order_release);
+
+  sfxMix(out, frames);
+}
+
+#ifdef MUSIC_THREADED
+
+static void *decoderMain(void *arg){
+  (void) arg;
+  musicPlayer *m = &s_music;
+  pthread_mutex_lock(&m->lock);
+  while (!m->quit){
+    if (m->hasPending){
+      musicTrack next = m->pending;
+      m->hasPending = false;
+      pthread_mutex_unlock(&m->lock);
+      UnloadFileData(m->track.data);
+      m->track = next;
+      m->frameLen = m->frameRead = 0;
+      atomic_store_explicit(&m->flush, 1, memory_order_release);
+      pthread_mutex_lock(&m->lock);
+      continue;
+    }
+
+    pthread_mutex_unlock(&m->lock);
+    fillRing();
+    pthread_mutex_lock(&m->lock);
+
+    // The ring holds far more than one refill period, so polling is enough
+    if (!m->quit && !m->hasPending){
+      struct timespec until;
+      clock_gettime(CLOCK_REALTIME, &until);
+      until.tv_nsec += MUSIC_REFILL_MS * 1000000L;
+      if (until.tv_nsec >= 1000000000L){
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+      }
+      pthread_cond_timedwait(&m->wake, &m->lock, &until);
+    }
+  }
+  pthread_mutex_unlock(&m->lock);
+  return NULL;
+}
+
+#endif
+
+void musicInit(void){
+  buildDequantTable();
+  s_music.stream = LoadAudioStream(MUSIC_SAMPLE_RATE, 16, MUSIC_CHANNELS);
+  if (s_music.stream.buffer == NULL){
+    TraceLog(LOG_WARNING, "MUSIC: no audio stream, music is off");
+    return;
+  }
+  SetAudioStreamCallback(s_music.stream, musicCallback);
+  PlayAudioStream(s_music.stream);
+
+#ifdef MUSIC_THREADED
+  pthread_mutex_init(&s_music.lock, NULL);
+  pthread_cond_init(&s_music.wake, NULL);
+  if (pthread_create(&s_music.thread, NULL, &decoderMain, NULL) != 0){
+    TraceLog(LOG_WARNING, "MUSIC: no decoder thread, music is off");
+    pthread_cond_destroy(&s_music.wake);
+    pthread_mutex_destroy(&s_music.lock);
+    UnloadAudioStream(s_music.stream);
+    return;
+  }
+#endif
+  s_music.ready = true;
+}
+
+void musicShutdown(void){
+  if (!s_music.ready) return;
+  // Stops the callbacks before the decoder state goes away
+  UnloadAudioStream(s_music.stream);
+
+#ifdef MUSIC_THREADED
+  pthread_mutex_lock(&s_music.lock);
+  s_music.quit = true;
+  pthread_cond_signal(&s_music.wake);
+  pthread_mutex_unlock(&s_music.lock);
+  pthread_join(s_music.thread, NULL);
+  if (s_music.hasPending) UnloadFileData(s_music.pending.data);
+  pthread_cond_destroy(&s_music.wake);
+  pthread_mutex_destroy(&s_music.lock);
+#endif
+  UnloadFileData(s_music.track.data);
+  memset(&s_music, 0, sizeof(s_music));
+}
+
+void musicPlay(const char *path){
+  if (!s_music.ready) return;
+
+  musicTrack next = {0};
+  if (path != NULL){
+    int size = 0;
+    unsigned char *data = LoadFileData(assetsPath(path), &size);
+    if (data != NULL && (size < 16 || (readU64(data) >> 32) != QOA_MAGIC)){
+      TraceLog(LOG_WARNING, "MUSIC: %s is not a QOA file", path);
+      UnloadFileData(data);
+      data = NULL;
+    }
+    if (data != NULL) next = (musicTrack){ data, size, 8 };
+  }
+
+#ifdef MUSIC_THREADED
+  pthread_mutex_lock(&s_music.lock);
+  if (s_music.hasPending) UnloadFileData(s_music.pending.data);
+  s_music.pending = next;
+  s_music.hasPending = true;
+  pthread_cond_signal(&s_music.wake);
+  pthread_mutex_unlock(&s_music.lock);
+#else
+  // The callback runs on this same thread here, so the swap cannot race it
+  UnloadFileData(s_music.track.data);
+  s_music.track = next;
+  s_music.frameLen = s_music.frameRead = 0;
+  atomic_store(&s_music.tail, atomic_load(&s_music.head));
+#endif
+}
@@ -0,0 +1,21 @@
+#ifndef MUSIC_H
+#define MUSIC_H
+
+// Background music. Tracks are QOA files (tools/music.c converts the WAVs)
+// decoded on a thread of their own into a lock-free ring that the audio
+// device's callback drains, so the game loop never pumps audio and a slow
+// frame cannot starve the device. Web builds have no threads and decode
+// inside the callback instead. The same callback mixes the sound effects
+// (sfx.h) over the music.
+#define MUSIC_SAMPLE_RATE 48000
+#define MUSIC_CHANNELS 2
+
+// After InitAudioDevice.
+extern void musicInit(void);
+// Before CloseAudioDevice.
+extern void musicShutdown(void);
+// Loops the track at `path`, relative to the assets directory, in place of
+// whatever was playing. NULL stops the music.
+extern void musicPlay(const char *path);
+
+#endif
@@ -6,84 +6,109 @@
 #include "physics.h"
 #include "npc.h"
 #include "hash.h"
+#include "utils.h"
 
-NPC npcCreate(int x, int y, int width, int height){
-    NPC npc = malloc(sizeof(struct NPC));
-    npc->e = entityCreate(x, y, width, height);
-    if (GetRandomValue(1,100) <= 50)
-        npc->type = NPC_TYPE_VILLAGER;
+npcSpawn npcSpawnRoll(rng *r, int x, int y){
+    npcSpawn spawn;
+    spawn.x = x;
+    spawn.y = y;
+    if (rngRange(r, 1, 100) <= 50)
+        spawn.type = NPC_TYPE_VILLAGER;
     else
-        npc->type = NPC_TYPE_COW;
-    npc->state = 0; // idle
-    npc->currentFrame = GetRandomValue(0,3);
-    npc->animTimer = 0.0f;
+        spawn.type = NPC_TYPE_COW;
+    spawn.currentFrame = rngRange(r, 0, 3);
+    spawn.stateTimer = (rngRange(r, 50, 300) / 100.0f); // 0.5 - 3.0s idle initially
+    spawn.speed = (rngRange(r, 10, 40) / 90.0f); // slower speeds
+    return spawn;
+}
+
+void npcGroupInit(npcGroup *g, arena a, const npcSpawn *spawns, int count){
+    g->count = count;
+    g->hot = arenaAlloc(a, (count > 0 ? count : 1) * sizeof(npcHot));
+    g->npcs = arenaAlloc(a, (count > 0 ? count : 1) * sizeof(struct NPC));
+    for (int i = 0; i < count; i++){
+        npcHot *hot = &g->hot[i];
+        hot->body.pos = (Vector2){ spawns[i].x, spawns[i].y };
+        hot->body.rect = (Rectangle){ spawns[i].x, spawns[i].y, NPC_SIZE, NPC_SIZE };
+        hot->vel = (Vector2){0.0f, 0.0f};
+        hot->state = 0; // idle
+        hot->collided = false;
+
+        NPC npc = &g->npcs[i];
+        npc->e = &hot->body;
+        npc->hot = hot;
+        npc->type = spawns[i].type;
+        npc->currentFrame = spawns[i].currentFrame;
+        npc->animTimer = 0.0f;
+        npc->stateTimer = spawns[i].stateTimer;
+        npc->moveTimer = 0.0f;
+        npc->speed = spawns[i].speed;
 
-    // init new fields
-    npc->vel = (Vector2){0.0f, 0.0f};
-    npc->stateTimer = (GetRandomValue(50,300) / 100.0f); // 0.5 - 3.0s idle initially
-    npc->moveTimer = 0.0f;
-    npc->speed = (GetRandomValue(10,40) / 90.0f); // slower speeds
+        // initialize facing
+        npc->facingRight = 1;
 
-    // initialize facing
-    npc->facingRight = 1;
+        // turning smoothing
+        npc->facingTimer = 0.0f;
+        npc->facingDelay = 0.12f; // hold new direction for 120ms before flipping
+        npc->lastVelX = 0.0f;
+    }
+}
 
-    // turning smoothing
-    npc->facingTimer = 0.0f;
-    npc->facingDelay = 0.12f; // hold new direction for 120ms before flipping
-    npc->lastVelX = 0.0f;
-    return npc; 
+void npcMove(npcHot *npc, tilemap map){
+    npc->collided = npc->state == 1 && update(&npc->body, map, npc->vel);
 }
 
-void npcUpdate(NPC npc, hash map){
+void npcUpdate(NPC npc){
     if (!npc) return;
-    float dt = GetFrameTime();
+    float dt = gameFrameTime();
 
     // Animation update (same for idle/wander)
     npc->animTimer += dt;
-    float maxAnimTime = (npc->state == 0) ? 0.3f : 0.1f;
+    float maxAnimTime = (npc->hot->state == 0) ? 0.3f : 0.1f;
     if (npc->animTimer > maxAnimTime) {
         npc->animTimer = 0.0f;
         npc->currentFrame = (npc->currentFrame + 1) % 4;
     }
 
     // State machine: 0 = idle, 1 = wander
-    if (npc->state == 0) {
+    if (npc->hot->state == 0) {
         // idle: count down, then start wandering
         npc->stateTimer -= dt;
         if (npc->stateTimer <= 0.0f) {
             // enter wander
-            npc->state = 1;
+            npc->hot->state = 1;
             npc->moveTimer = (GetRandomValue(30,150) / 60.0f); // 0.5 - 2.5s
             float ang = (GetRandomValue(0,359) * (PI / 180.0f));
-            npc->vel.x = cosf(ang) * npc->speed;
-            npc->vel.y = sinf(ang) * npc->speed;
+            npc->hot->vel.x = cosf(ang) * npc->speed;
+            npc->hot->vel.y = sinf(ang) * npc->speed;
             // small jitter: if vel nearly zero, re-randomize
-            if (fabsf(npc->vel.x) < 0.001f && fabsf(npc->vel.y) < 0.001f) {
-                npc->vel.x = npc->speed;
-                npc->vel.y = 0;
+            if (fabsf(npc->hot->vel.x) < 0.001f && fabsf(npc->hot->vel.y) < 0.001f) {
+                npc->hot->vel.x = npc->speed;
+                npc->hot->vel.y = 0;
             }
             // if strong horizontal intent on start, immediately set facing target but still respect delay
-            npc->lastVelX = npc->vel.x;
+            npc->lastVelX = npc->hot->vel.x;
             npc->facingTimer = 0.0f;
         }
     } else {
         // wander: move and count down; if collision, pick new direction
-        bool collided = update(npc->e, map, npc->vel);
+        bool collided = npc->hot->collided;
+        npc->hot->collided = false;
         npc->moveTimer -= dt;
         if (collided) {
             // pick a new random direction and slightly shorten remaining time
             float ang = (GetRandomValue(0,359) * (PI / 180.0f));
-            npc->vel.x = cosf(ang) * npc->speed;
-            npc->vel.y = sinf(ang) * npc->speed;
+            npc->hot->vel.x = cosf(ang) * npc->speed;
+            npc->hot->vel.y = sinf(ang) * npc->speed;
             npc->moveTimer = fmaxf(0.1f, npc->moveTimer - 0.05f);
-            npc->lastVelX = npc->vel.x;
+            npc->lastVelX = npc->hot->vel.x;
             npc->facingTimer = 0.0f;
         }
         // if wander time finished, snap to idle
         if (npc->moveTimer <= 0.0f) {
-            npc->state = 0;
+            npc->hot->state = 0;
             npc->stateTimer = (GetRandomValue(50,300) / 100.0f); // 0.5 - 3.0s
-            npc->vel = (Vector2){0.0f, 0.0f};
+            npc->hot->vel = (Vector2){0.0f, 0.0f};
         } else {
             // update facing while moving (with smoothing below)
             // nothing here; handled after state machine
@@ -93,7 +118,7 @@ void npcUpdate(NPC npc, hash map){
     // --- Smooth facing logic (hysteresis + delay) ---
     {
         const float FLIP_THRESHOLD = fmaxf(0.04f, npc->speed * 0.15f); // avoid flips on tiny jitter
-        float horiz = npc->vel.x;
+        float horiz = npc->hot->vel.x;
         float absH = fabsf(horiz);
         if (absH > FLIP_THRESHOLD) {
             int want = (horiz > 0.0f) ? 1 : -1;
@@ -110,6 +135,6 @@ void npcUpdate(NPC npc, hash map){
             // when horizontal input small, decay timer but don't flip
             npc->facingTimer = fmaxf(0.0f, npc->facingTimer - dt);
         }
-        npc->lastVelX = npc->vel.x;
+        npc->lastVelX = npc->hot->vel.x;
     }
 }
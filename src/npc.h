@@ -3,21 +3,34 @@
 
 #include "raylib.h"
 #include "hash.h"
+#include "map.h"
+#include "physics.h"
+#include "arena.h"
+#include "rng.h"
 
 typedef enum{
     NPC_TYPE_VILLAGER, 
     NPC_TYPE_COW
 } NPCType;
 
+#define NPC_SIZE 15     // side of the collision box
+
+// What npcMove needs every frame, packed apart from the rest of the npc
+typedef struct npcHot{
+    struct entity body; // the npc's e points here
+    Vector2 vel;        // per-frame delta applied to entity via update()
+    int state; // 0 is idle // 1 is wander 
+    bool collided;      // npcMove hit a wall this frame
+} npcHot;
+
 struct NPC{
     entity e;
+    npcHot *hot;
     NPCType type; 
-    int state; // 0 is idle // 1 is wander 
     int currentFrame; 
     float animTimer; 
 
     // Added fields:
-    Vector2 vel;        // per-frame delta applied to entity via update()
     float stateTimer;   // time left in current idle/wait state (seconds)
     float moveTimer;    // time left while wandering (seconds)
     float speed;        // movement speed (per-frame units)
@@ -32,8 +45,28 @@ struct NPC{
 };
 typedef struct NPC *NPC;
 
-extern NPC npcCreate(int x, int y, int width, int height);
-// Updated signature: pass map so movement uses collision
-extern void npcUpdate(NPC npc, hash map);
+// Where and what an npc starts as, rolled where the chunk places it
+typedef struct npcSpawn{
+    int x, y;
+    NPCType type;
+    int currentFrame;
+    float stateTimer;
+    float speed;
+} npcSpawn;
+
+// The npcs of one room: hot[i] and npcs[i] are the two halves of npc i
+typedef struct npcGroup{
+    int count;
+    npcHot *hot;
+    struct NPC *npcs;
+} npcGroup;
+
+extern npcSpawn npcSpawnRoll(rng *r, int x, int y);
+extern void npcGroupInit(npcGroup *g, arena a, const npcSpawn *spawns, int count);
+// Moves a wandering npc against the map. Touches nothing but the npc, so
+// npcs can move in parallel; call it before npcUpdate every frame.
+extern void npcMove(npcHot *npc, tilemap map);
+// Animation, facing and the wander decisions, reacting to npcMove's collision
+extern void npcUpdate(NPC npc);
 
 #endif // NPC_H
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "raylib.h"
+#include "pack.h"
+
+// Desktop Unix maps the file; Android reads through the APK's asset
+// manager and Web/Windows have no mmap, so they load it whole.
+#if defined(__unix__) && !defined(PLATFORM_ANDROID) && !defined(PLATFORM_WEB)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define PACK_MMAP
+#endif
+
+struct assetPack{
+  unsigned char *data;
+  size_t size;
+  const packEntry *entries;
+  int count;
+};
+
+static bool mapFile(const char *path, struct assetPack *p){
+#ifdef PACK_MMAP
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0){
+    close(fd);
+    return false;
+  }
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return false;
+  p->data = data;
+  p->size = (size_t)st.st_size;
+  return true;
+#else
+  // FileExists cannot see inside the APK, so just try the load
+  int size = 0;
+  p->data = LoadFileData(path, &size);
+  p->size = size > 0 ? (size_t)size : 0;
+  return p->data != NULL;
+#endif
+}
+
+static void unmapFile(struct assetPack *p){
+#ifdef PACK_MMAP
+  munmap(p->data, p->size);
+#else
+  UnloadFileData(p->data);
+#endif
+}
+
+assetPack packOpen(const char *path){
+  struct assetPack file = {0};
+  if (!mapFile(path, &file)) return NULL;
+
+  packHeader header;
+  bool valid = file.size >= sizeof(header);
+  if (valid){
+    memcpy(&header, file.data, sizeof(header));
+    valid = memcmp(header.magic, PACK_MAGIC, 4) == 0 && header.version == PACK_VERSION &&
+            header.count <= (file.size - sizeof(header)) / sizeof(packEntry);
+  }
+  if (!valid){
+    TraceLog(LOG_WARNING, "PACK: %s is not a version %d pack", path, PACK_VERSION);
+    unmapFile(&file);
+    return NULL;
+  }
+
+  assetPack p = malloc(sizeof(struct assetPack));
+  assert(p != NULL);
+  *p = file;
+  p->entries = (const packEntry *)(p->data + sizeof(header));
+  p->count = (int)header.count;
+  TraceLog(LOG_INFO, "PACK: %s opened, %d images", path, p->count);
+  return p;
+}
+
+void packClose(assetPack p){
+  if (p == NULL) return;
+  unmapFile(p);
+  free(p);
+}
+
+bool packImage(assetPack p, const char *name, Image *out){
+  if (p == NULL) return false;
+  int lo = 0, hi = p->count - 1;
+  while (lo <= hi){
+    int mid = (lo + hi) / 2;
+    const packEntry *e = &p->entries[mid];
+    int cmp = strncmp(name, e->name, PACK_NAME_MAX);
+    if (cmp < 0) hi = mid - 1;
+    else if (cmp > 0) lo = mid + 1;
+    else {
+      uint64_t bytes = (uint64_t)e->width * e->height * 4;
+      if (e->offset > p->size || bytes > p->size - e->offset) return false;
+      *out = (Image){
+        .data = p->data + e->offset,
+        .width = (int)e->width,
+        .height = (int)e->height,
+        .mipmaps = 1,
+        .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+      };
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,39 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "raylib.h"
+
+// textures.pak, written by tools/pack.c: a header, a table of contents
+// sorted by name, then every image as raw RGBA8 pixels. The game maps the
+// file and hands the pixels straight to the GPU, no PNG decode at all.
+#define PACK_MAGIC "VPAK"
+#define PACK_VERSION 1
+#define PACK_NAME_MAX 56
+#define PACK_ALIGN 16
+
+typedef struct packHeader{
+  char magic[4];
+  uint32_t version;
+  uint32_t count;
+  uint32_t reserved;
+} packHeader;
+
+typedef struct packEntry{
+  char name[PACK_NAME_MAX];     // relative to assets/, e.g. "tiles/dirt.png"
+  uint32_t width, height;
+  uint64_t offset;              // from the start of the file, PACK_ALIGN aligned
+} packEntry;
+
+typedef struct assetPack *assetPack;
+
+// NULL when the file is missing or not a pack of this version.
+extern assetPack packOpen(const char *path);
+extern void packClose(assetPack p);
+// The image points into the pack, so it must not be unloaded and is only
+// valid until packClose.
+extern bool packImage(assetPack p, const char *name, Image *out);
+
+#endif
@@ -16,6 +16,14 @@ entity entityCreate(float startX, float startY, int width, int height){
   return e; 
 }
 
+// Same as entityCreate but owned by an arena (e.g. the level), never freed on its own
+entity entityCreateIn(arena a, float startX, float startY, int width, int height){
+  entity e = arenaAlloc(a, sizeof(struct entity));
+  e->pos = (Vector2) {startX, startY};
+  e->rect = (Rectangle) {startX, startY, width, height};
+  return e; 
+}
+
 // static bool collideRect(entity e, hash map, rect *hitTile){
 //     dynarray arr = rectsAround(map, e->pos);
 //     for (int i = 0; i < arr->len; i++){
@@ -31,7 +39,7 @@ entity entityCreate(float startX, float startY, int width, int height){
 // }
 
 // I dont think so the copy works here. 
-static bool collideRect(entity e, hash map, rect *hitTile){
+static bool collideRect(entity e, tilemap map, rect *hitTile){
     struct rect nearby[MAX_RECTS];          // static array to hold rects
     int count = rectsAround(map, e->pos, nearby); // fill array and get count
 
@@ -48,7 +56,7 @@ static bool collideRect(entity e, hash map, rect *hitTile){
 }
 
 // Returns true if collided
-bool update(entity e, hash map, Vector2 newPos) {
+bool update(entity e, tilemap map, Vector2 newPos) {
     Vector2 oldPos = e->pos;
     bool collided = false;
     // --- X axis first ---
@@ -3,6 +3,8 @@
 
 #include "raylib.h"
 #include "hash.h"
+#include "map.h"
+#include "arena.h"
 
 
 struct entity{
@@ -12,6 +14,7 @@ struct entity{
 typedef struct entity *entity;
 
 extern entity entityCreate(float startX, float startY, int width, int height);
-extern bool update(entity e, hash map, Vector2 newPos);
+extern entity entityCreateIn(arena a, float startX, float startY, int width, int height);
+extern bool update(entity e, tilemap map, Vector2 newPos);
 
 #endif
\ No newline at end of file
@@ -20,7 +20,7 @@ void projectileShoot(dynarray projectiles, Vector2 playerPos, Vector2 dir, float
     add_dynarray(projectiles, p);
 }   
 
-bool projectileUpdate(projectile p, hash map){
+bool projectileUpdate(projectile p, tilemap map){
     return update(p->e, map, p->dir);
 }
 
@@ -20,7 +20,7 @@ struct projectile{
 typedef struct projectile *projectile;
 
 extern void projectileShoot(dynarray projectiles, Vector2 playerPos, Vector2 dir, float speed, GUN_TYPE gun_type);
-extern bool projectileUpdate(projectile p, hash map);
+extern bool projectileUpdate(projectile p, tilemap map);
 extern void projectileDraw(projectile p);
 extern void projectileFree(projectile p);
 
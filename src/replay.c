@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+#include "replay.h"
+
+#define REPLAY_MAGIC    0x59504C52u     // "RLPY"
+#define REPLAY_VERSION  1
+
+typedef struct replayHeader{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t worldSeed;
+  uint32_t randomSeed;
+  uint32_t reserved;
+} replayHeader;
+
+// One game frame, 16 bytes
+typedef struct replayFrame{
+  float dt;
+  int16_t moveX, moveY;   // stick values scaled by 32767
+  int16_t aimX, aimY;
+  uint16_t buttons;       // REPLAY_* bits
+  uint16_t reserved;
+} replayFrame;
+
+struct replay{
+  bool playing;
+  replayHeader header;
+  replayFrame frame;      // the frame being recorded or played
+  FILE *out;              // recording
+  replayFrame *frames;    // playback
+  int frameCount;
+  int next;
+};
+
+static int16_t quantise(float v){
+  if (v > 1.0f) v = 1.0f;
+  if (v < -1.0f) v = -1.0f;
+  return (int16_t) lroundf(v * 32767.0f);
+}
+
+static float dequantise(int16_t q){
+  return q / 32767.0f;
+}
+
+replay replayRecord(const char *path, uint64_t worldSeed, uint32_t randomSeed){
+  FILE *out = fopen(path, "wb");
+  if (!out){
+    TraceLog(LOG_WARNING, "Cannot record replay to %s", path);
+    return NULL;
+  }
+  replay r = calloc(1, sizeof(struct replay));
+  assert(r != NULL);
+  r->header = (replayHeader){ REPLAY_MAGIC, REPLAY_VERSION, worldSeed, randomSeed, 0 };
+  r->out = out;
+  fwrite(&r->header, sizeof(r->header), 1, out);
+  return r;
+}
+
+replay replayPlay(const char *path){
+  FILE *in = fopen(path, "rb");
+  if (!in){
+    TraceLog(LOG_WARNING, "Cannot open replay %s", path);
+    return NULL;
+  }
+  replay r = calloc(1, sizeof(struct replay));
+  assert(r != NULL);
+  r->playing = true;
+
+  fseek(in, 0, SEEK_END);
+  long size = ftell(in);
+  fseek(in, 0, SEEK_SET);
+  if (size < (long)sizeof(replayHeader) ||
+      fread(&r->header, sizeof(r->header), 1, in) != 1 ||
+      r->header.magic != REPLAY_MAGIC || r->header.version != REPLAY_VERSION){
+    TraceLog(LOG_WARNING, "Replay %s is not a version %d replay", path, REPLAY_VERSION);
+    fclose(in);
+    free(r);
+    return NULL;
+  }
+
+  // the whole stream is read up front so playback does no file IO
+  r->frameCount = (int) ((size - (long)sizeof(replayHeader)) / (long)sizeof(replayFrame));
+  r->frames = malloc((r->frameCount > 0 ? r->frameCount : 1) * sizeof(replayFrame));
+  assert(r->frames != NULL);
+  r->frameCount = (int) fread(r->frames, sizeof(replayFrame), r->frameCount, in);
+  fclose(in);
+  TraceLog(LOG_INFO, "Replaying %d frames from %s", r->frameCount, path);
+  return r;
+}
+
+uint64_t replayWorldSeed(replay r){
+  return r->header.worldSeed;
+}
+
+uint32_t replayRandomSeed(replay r){
+  return r->header.randomSeed;
+}
+
+bool replayPlaying(replay r){
+  return r && r->playing;
+}
+
+bool replayFinished(replay r){
+  return r && r->playing && r->next >= r->frameCount;
+}
+
+float replayBeginFrame(replay r, float dt){
+  if (!r) return dt;
+  if (r->playing){
+    if (r->next < r->frameCount) r->frame = r->frames[r->next];
+    return r->frame.dt;
+  }
+  r->frame = (replayFrame){ .dt = dt };
+  return dt;
+}
+
+void replaySticks(replay r, Vector2 *move, Vector2 *aim, bool *shooting){
+  if (!r) return;
+  if (!r->playing){
+    r->frame.moveX = quantise(move->x);
+    r->frame.moveY = quantise(move->y);
+    r->frame.aimX = quantise(aim->x);
+    r->frame.aimY = quantise(aim->y);
+    if (*shooting) r->frame.buttons |= REPLAY_SHOOT;
+  }
+  *move = (Vector2){ dequantise(r->frame.moveX), dequantise(r->frame.moveY) };
+  *aim = (Vector2){ dequantise(r->frame.aimX), dequantise(r->frame.aimY) };
+  *shooting = (r->frame.buttons & REPLAY_SHOOT) != 0;
+}
+
+bool replayButton(replay r, int button, bool live){
+  if (!r) return live;
+  if (r->playing) return (r->frame.buttons & button) != 0;
+  if (live) r->frame.buttons |= button;
+  return live;
+}
+
+void replayEndFrame(replay r){
+  if (!r) return;
+  if (r->playing){
+    r->next++;
+    return;
+  }
+  fwrite(&r->frame, sizeof(r->frame), 1, r->out);
+}
+
+void replayClose(replay r){
+  if (!r) return;
+  if (r->out) fclose(r->out);
+  free(r->frames);
+  free(r);
+}
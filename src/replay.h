@@ -0,0 +1,39 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "raylib.h"
+
+// Records everything the game loop reads from the player (frame time,
+// stick values and button presses) together with the seeds, and plays it
+// back through the same code paths. A NULL replay passes live input through.
+typedef struct replay *replay;
+
+// Buttons and other per-frame decisions that are not stick values
+#define REPLAY_SHOOT        (1 << 0)
+#define REPLAY_HACK         (1 << 1)
+#define REPLAY_NEXT_LEVEL   (1 << 2)
+#define REPLAY_LEVEL_READY  (1 << 3)   // the loader had the level done
+
+extern replay replayRecord(const char *path, uint64_t worldSeed, uint32_t randomSeed);
+extern replay replayPlay(const char *path);
+extern uint64_t replayWorldSeed(replay r);
+extern uint32_t replayRandomSeed(replay r);
+extern bool replayPlaying(replay r);
+// True once playback has run out of recorded frames.
+extern bool replayFinished(replay r);
+
+// Start of a frame: takes the live frame time, returns the one to simulate.
+extern float replayBeginFrame(replay r, float dt);
+// Record the live stick values, or overwrite them with the recorded ones.
+// Recorded values are quantised, and so are the live ones while recording,
+// so the recorded run and its playback see exactly the same input.
+extern void replaySticks(replay r, Vector2 *move, Vector2 *aim, bool *shooting);
+// Record a live button, or return the recorded one.
+extern bool replayButton(replay r, int button, bool live);
+extern void replayEndFrame(replay r);
+extern void replayClose(replay r);
+
+#endif
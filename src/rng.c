@@ -0,0 +1,37 @@
+#include "rng.h"
+
+void rngSeed(rng *r, uint64_t seed, uint64_t stream){
+    r->state = 0;
+    r->inc = (stream << 1) | 1u;
+    rngNext(r);
+    r->state += seed;
+    rngNext(r);
+}
+
+uint32_t rngNext(rng *r){
+    uint64_t old = r->state;
+    r->state = old * 6364136223846793005ULL + r->inc;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+uint32_t rngHash(uint64_t seed, int x, int y){
+    uint64_t h = seed ^ ((uint64_t)(uint32_t)x * 0x9E3779B97F4A7C15ULL)
+                      ^ ((uint64_t)(uint32_t)y * 0xC2B2AE3D27D4EB4FULL);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return (uint32_t)h;
+}
+
+int rngRange(rng *r, int min, int max){
+    if (min > max){
+        int t = min; min = max; max = t;
+    }
+    uint32_t span = (uint32_t)(max - min) + 1u;
+    if (span == 0) return (int)rngNext(r);
+    return min + (int)(((uint64_t)rngNext(r) * span) >> 32);
+}
@@ -0,0 +1,20 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Small PCG32 generator. Unlike rand()/GetRandomValue the state is a
+// value the caller owns, so generation can run off the main thread.
+typedef struct{
+  uint64_t state;
+  uint64_t inc;
+} rng;
+
+extern void rngSeed(rng *r, uint64_t seed, uint64_t stream);
+extern uint32_t rngNext(rng *r);
+// Inclusive on both ends, like GetRandomValue.
+extern int rngRange(rng *r, int min, int max);
+// Stateless value for a grid cell, same seed and cell always give the same bits.
+extern uint32_t rngHash(uint64_t seed, int x, int y);
+
+#endif
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#include "raylib.h"
+#include "music.h"
+#include "sfx.h"
+
+#define SFX_EVENTS 64             // per-frame batches, a power of two
+#define SFX_MASTER 0.6f
+#define SFX_FADE_OUT 0.005f       // seconds, so no sound ends in a click
+
+// Every sound is a filtered noise burst over a falling sine, which covers
+// gunfire, impacts and thumps. noiseColor is the low-pass coefficient:
+// small values give a dull boom, values near 1 a sharp crack.
+typedef struct sfxSound{
+  float length;
+  float noiseDecay, noiseColor, noiseMix;
+  float toneFrom, toneTo, toneDecay, toneMix;
+  int priority;
+} sfxSound;
+
+static const sfxSound s_sounds[SFX_COUNT] = {
+  [SFX_SNIPER]     = { 0.45f,  9.0f, 0.35f, 0.9f,  90.0f,  40.0f, 10.0f, 0.8f, 3 },
+  [SFX_SMG]        = { 0.12f, 35.0f, 0.60f, 0.8f, 180.0f,  90.0f, 40.0f, 0.4f, 3 },
+  [SFX_UZI]        = { 0.10f, 40.0f, 0.70f, 0.8f, 220.0f, 110.0f, 45.0f, 0.4f, 3 },
+  [SFX_PISTOL]     = { 0.18f, 25.0f, 0.50f, 0.8f, 150.0f,  70.0f, 30.0f, 0.5f, 3 },
+  [SFX_SHOTGUN]    = { 0.35f, 12.0f, 0.30f, 1.0f,  80.0f,  45.0f, 14.0f, 0.8f, 3 },
+  [SFX_MINIGUN]    = { 0.08f, 50.0f, 0.65f, 0.7f, 200.0f, 120.0f, 60.0f, 0.3f, 3 },
+  [SFX_ENEMY_SHOT] = { 0.15f, 30.0f, 0.45f, 0.6f, 260.0f, 120.0f, 35.0f, 0.4f, 1 },
+  [SFX_HIT]        = { 0.10f, 45.0f, 0.25f, 0.5f, 120.0f,  60.0f, 30.0f, 0.7f, 1 },
+  [SFX_KILL]       = { 0.30f, 15.0f, 0.20f, 0.5f, 160.0f,  50.0f, 10.0f, 0.8f, 2 },
+  [SFX_HURT]       = { 0.25f, 20.0f, 0.30f, 0.4f, 320.0f, 140.0f, 12.0f, 0.8f, 4 },
+};
+
+typedef struct sfxEvent{
+  int id;
+  int gainL, gainR;             // Q15
+} sfxEvent;
+
+typedef struct sfxVoice{
+  const int16_t *pcm;           // NULL when the voice is free
+  int length, pos;
+  int gainL, gainR;
+  int priority;
+} sfxVoice;
+
+typedef struct sfxPending{
+  int count;
+  float volume;                 // loudest of the merged plays
+  float panSum, weight;         // volume weighted pan
+} sfxPending;
+
+typedef struct sfxMixer{
+  bool ready;
+  int16_t *pcm;
+  int offset[SFX_COUNT], length[SFX_COUNT];
+
+  // Main thread: this frame's plays, merged per sound
+  sfxPending pending[SFX_COUNT];
+
+  // Main thread to audio thread, single producer and single consumer
+  sfxEvent events[SFX_EVENTS];
+  atomic_uint head, tail;
+
+  // Audio thread only
+  sfxVoice voices[SFX_VOICES];
+} sfxMixer;
+
+static sfxMixer s_sfx = {0};
+
+static void synthesize(const sfxSound *snd, int16_t *out, int length, uint32_t seed){
+  const float rate = (float)MUSIC_SAMPLE_RATE;
+  int fade = (int)(SFX_FADE_OUT * rate);
+  float lp = 0.0f, phase = 0.0f;
+  for (int i = 0; i < length; i++){
+    float t = i / rate;
+    // Own LCG so the game's RNG streams, and with them replays, are untouched
+    seed = seed * 1664525u + 1013904223u;
+    float white = (float)(seed >> 8) / (float)(1u << 23) - 1.0f;
+    lp += snd->noiseColor * (white - lp);
+
+    float freq = snd->toneFrom + (snd->toneTo - snd->toneFrom) * t / snd->length;
+    phase += 2.0f * PI * freq / rate;
+    float s = snd->noiseMix * lp * expf(-t * snd->noiseDecay) +
+              snd->toneMix * sinf(phase) * expf(-t * snd->toneDecay);
+    if (i > length - fade) s *= (float)(length - i) / fade;
+
+    s = s < -1.0f ? -1.0f : (s > 1.0f ? 1.0f : s);
+    out[i] = (int16_t)(s * 30000.0f);
+  }
+}
+
+void sfxInit(void){
+  int total = 0;
+  for (int i = 0; i < SFX_COUNT; i++){
+    s_sfx.offset[i] = total;
+    s_sfx.length[i] = (int)(s_sounds[i].length * MUSIC_SAMPLE_RATE);
+    total += s_sfx.length[i];
+  }
+  s_sfx.pcm = malloc(sizeof(int16_t) * total);
+  assert(s_sfx.pcm != NULL);
+  for (int i = 0; i < SFX_COUNT; i++)
+    synthesize(&s_sounds[i], s_sfx.pcm + s_sfx.offset[i], s_sfx.length[i], 0x5eed0000u + i);
+  s_sfx.ready = true;
+}
+
+void sfxUnload(void){
+  free(s_sfx.pcm);
+  memset(&s_sfx, 0, sizeof(s_sfx));
+}
+
+void sfxPlay(sfxId id, float volume, float pan){
+  if (!s_sfx.ready || volume <= 0.0f) return;
+  sfxPending *p = &s_sfx.pending[id];
+  p->count++;
+  if (volume > p->volume) p->volume = volume;
+  p->panSum += pan * volume;
+  p->weight += volume;
+}
+
+void sfxPlayAt(sfxId id, Vector2 pos, Vector2 listener){
+  float dx = pos.x - listener.x, dy = pos.y - listener.y;
+  float volume = 1.0f / (1.0f + sqrtf(dx * dx + dy * dy) / 160.0f);
+  float pan = dx / 240.0f;
+  sfxPlay(id, volume, pan < -1.0f ? -1.0f : (pan > 1.0f ? 1.0f : pan));
+}
+
+void sfxFlush(void){
+  if (!s_sfx.ready) return;
+  unsigned head = atomic_load_explicit(&s_sfx.head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&s_sfx.tail, memory_order_acquire);
+  for (int id = 0; id < SFX_COUNT; id++){
+    sfxPending *p = &s_sfx.pending[id];
+    if (p->count == 0) continue;
+    // Merged plays come out a little louder than one, never as loud as all
+    float volume = fminf(1.0f, p->volume * (1.0f + 0.15f * (p->count - 1)));
+    float pan = p->panSum / p->weight;
+    *p = (sfxPending){0};
+    if (head - tail == SFX_EVENTS) continue;     // audio thread stalled, drop
+
+    // Equal power panning
+    float angle = (pan + 1.0f) * PI * 0.25f;
+    float gain = volume * SFX_MASTER * 32768.0f;
+    s_sfx.events[head & (SFX_EVENTS - 1)] = (sfxEvent){
+      id, (int)(gain * cosf(angle)), (int)(gain * sinf(angle))
+    };
+    head++;
+  }
+  atomic_store_explicit(&s_sfx.head, head, memory_order_release);
+}
+
+static void startVoice(const sfxEvent *ev){
+  int priority = s_sounds[ev->id].priority;
+  sfxVoice *voice = NULL;
+  for (int i = 0; i < SFX_VOICES && voice == NULL; i++){
+    if (s_sfx.voices[i].pcm == NULL) voice = &s_sfx.voices[i];
+  }
+  if (voice == NULL){
+    // Steal the lowest priority voice, the one nearest its end among equals
+    for (int i = 0; i < SFX_VOICES; i++){
+      sfxVoice *v = &s_sfx.voices[i];
+      if (v->priority > priority) continue;
+      if (voice == NULL || v->priority < voice->priority ||
+          (v->priority == voice->priority &&
+           (float)v->pos / v->length > (float)voice->pos / voice->length))
+        voice = v;
+    }
+    if (voice == NULL) return;
+  }
+  *voice = (sfxVoice){
+    s_sfx.pcm + s_sfx.offset[ev->id], s_sfx.length[ev->id], 0,
+    ev->gainL, ev->gainR, priority
+  };
+}
+
+void sfxMix(int16_t *out, unsigned int frames){
+  unsigned tail = atomic_load_explicit(&s_sfx.tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&s_sfx.head, memory_order_acquire);
+  for (; tail != head; tail++) startVoice(&s_sfx.events[tail & (SFX_EVENTS - 1)]);
+  atomic_store_explicit(&s_sfx.tail, tail, memory_order_release);
+
+  for (int v = 0; v < SFX_VOICES; v++){
+    sfxVoice *voice = &s_sfx.voices[v];
+    if (voice->pcm == NULL) continue;
+    int n = voice->length - voice->pos;
+    if (n > (int)frames) n = (int)frames;
+    const int16_t *src = voice->pcm + voice->pos;
+    for (int i = 0; i < n; i++){
+      int l = out[i * 2] + ((src[i] * voice->gainL) >> 15);
+      int r = out[i * 2 + 1] + ((src[i] * voice->gainR) >> 15);
+      out[i * 2] = (int16_t)(l < -32768 ? -32768 : (l > 32767 ? 32767 : l));
+      out[i * 2 + 1] = (int16_t)(r < -32768 ? -32768 : (r > 32767 ? 32767 : r));
+    }
+    voice->pos += n;
+    if (voice->pos >= voice->length) voice->pcm = NULL;
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef SFX_H
+#define SFX_H
+
+#include <stdint.h>
+
+#include "raylib.h"
+
+// Sound effects. The PCM is synthesized once by sfxInit, the game queues
+// events during a frame (identical sounds in one frame merge into one),
+// sfxFlush hands the frame's batch to the audio thread, and the music
+// callback mixes a fixed pool of voices over the music. Playing a sound
+// therefore costs the game loop a table write, whatever the fire rate.
+typedef enum {
+  SFX_SNIPER,
+  SFX_SMG,
+  SFX_UZI,
+  SFX_PISTOL,
+  SFX_SHOTGUN,
+  SFX_MINIGUN,
+  SFX_ENEMY_SHOT,
+  SFX_HIT,
+  SFX_KILL,
+  SFX_HURT,
+  SFX_COUNT
+} sfxId;
+
+// A new sound takes a free voice, else the most played voice of the
+// lowest priority that is not above its own, else it is dropped.
+#define SFX_VOICES 16
+
+extern void sfxInit(void);
+// After musicShutdown, once no callback can be mixing.
+extern void sfxUnload(void);
+
+// Main thread only. `pan` runs from -1 (left) to 1 (right).
+extern void sfxPlay(sfxId id, float volume, float pan);
+// Same, with volume and pan from where `pos` is relative to `listener`.
+extern void sfxPlayAt(sfxId id, Vector2 pos, Vector2 listener);
+// Once per frame, after the frame's sounds were played.
+extern void sfxFlush(void);
+
+// Audio thread: adds the playing voices onto `frames` interleaved stereo
+// frames at MUSIC_SAMPLE_RATE.
+extern void sfxMix(int16_t *out, unsigned int frames);
+
+#endif
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+#include "spatial.h"
+
+typedef struct spatialEntry{
+  Rectangle box;
+  unsigned kind;
+  void *item;
+  int next;            // next entry in the same cell, -1 ends the list
+} spatialEntry;
+
+struct spatialGrid{
+  float cellSize;
+  Rectangle bounds;
+  int cellsW, cellsH;
+  int *heads;          // first entry of each cell, -1 when empty
+  int headCap;
+  spatialEntry *entries;
+  int entryCount, entryCap;
+  float maxHalfW, maxHalfH;
+};
+
+spatialGrid spatialCreate(float cellSize){
+  spatialGrid g = calloc(1, sizeof(struct spatialGrid));
+  assert(g != NULL);
+  g->cellSize = cellSize;
+  return g;
+}
+
+void spatialFree(spatialGrid g){
+  if (!g) return;
+  free(g->heads);
+  free(g->entries);
+  free(g);
+}
+
+void spatialClear(spatialGrid g, Rectangle bounds){
+  g->bounds = bounds;
+  g->cellsW = (int)ceilf(bounds.width / g->cellSize);
+  g->cellsH = (int)ceilf(bounds.height / g->cellSize);
+  if (g->cellsW < 1) g->cellsW = 1;
+  if (g->cellsH < 1) g->cellsH = 1;
+
+  int cells = g->cellsW * g->cellsH;
+  if (cells > g->headCap){
+    g->heads = realloc(g->heads, cells * sizeof(int));
+    assert(g->heads != NULL);
+    g->headCap = cells;
+  }
+  for (int i = 0; i < cells; i++) g->heads[i] = -1;
+  g->entryCount = 0;
+  g->maxHalfW = g->maxHalfH = 0;
+}
+
+static inline int cellX(spatialGrid g, float x){
+  int c = (int)floorf((x - g->bounds.x) / g->cellSize);
+  return c < 0 ? 0 : (c >= g->cellsW ? g->cellsW - 1 : c);
+}
+
+static inline int cellY(spatialGrid g, float y){
+  int c = (int)floorf((y - g->bounds.y) / g->cellSize);
+  return c < 0 ? 0 : (c >= g->cellsH ? g->cellsH - 1 : c);
+}
+
+static inline int cellOf(spatialGrid g, Rectangle box){
+  return cellY(g, box.y + box.height / 2) * g->cellsW + cellX(g, box.x + box.width / 2);
+}
+
+void spatialInsert(spatialGrid g, Rectangle box, unsigned kind, void *item){
+  if (g->entryCount == g->entryCap){
+    g->entryCap = g->entryCap ? g->entryCap * 2 : 64;
+    g->entries = realloc(g->entries, g->entryCap * sizeof(spatialEntry));
+    assert(g->entries != NULL);
+  }
+  int cell = cellOf(g, box);
+  int i = g->entryCount++;
+  g->entries[i] = (spatialEntry){ box, kind, item, g->heads[cell] };
+  g->heads[cell] = i;
+
+  if (box.width / 2 > g->maxHalfW) g->maxHalfW = box.width / 2;
+  if (box.height / 2 > g->maxHalfH) g->maxHalfH = box.height / 2;
+}
+
+void spatialRemove(spatialGrid g, Rectangle box, void *item){
+  int *link = &g->heads[cellOf(g, box)];
+  while (*link != -1){
+    spatialEntry *e = &g->entries[*link];
+    if (e->item == item){
+      *link = e->next;
+      return;
+    }
+    link = &e->next;
+  }
+}
+
+// Both queries walk the cells any overlapping box can be centred in and
+// test each entry exactly; a radius query passes its circle in `centre`.
+static int query(spatialGrid g, Rectangle area, const Vector2 *centre, float radius,
+                 unsigned kinds, void **out, int max){
+  if (g->entryCount == 0) return 0;
+  int x0 = cellX(g, area.x - g->maxHalfW), x1 = cellX(g, area.x + area.width + g->maxHalfW);
+  int y0 = cellY(g, area.y - g->maxHalfH), y1 = cellY(g, area.y + area.height + g->maxHalfH);
+  int n = 0;
+  for (int cy = y0; cy <= y1; cy++){
+    for (int cx = x0; cx <= x1; cx++){
+      for (int i = g->heads[cy * g->cellsW + cx]; i != -1; i = g->entries[i].next){
+        spatialEntry *e = &g->entries[i];
+        if (!(e->kind & kinds)) continue;
+        bool hit = centre ? CheckCollisionCircleRec(*centre, radius, e->box)
+                          : CheckCollisionRecs(e->box, area);
+        if (!hit) continue;
+        if (n == max) return n;
+        out[n++] = e->item;
+      }
+    }
+  }
+  return n;
+}
+
+int spatialQueryRect(spatialGrid g, Rectangle area, unsigned kinds, void **out, int max){
+  return query(g, area, NULL, 0, kinds, out, max);
+}
+
+int spatialQueryRadius(spatialGrid g, Vector2 centre, float radius, unsigned kinds, void **out, int max){
+  Rectangle area = { centre.x - radius, centre.y - radius, radius * 2, radius * 2 };
+  return query(g, area, &centre, radius, kinds, out, max);
+}
@@ -0,0 +1,35 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <stdbool.h>
+
+#include "raylib.h"
+
+// Uniform-grid broadphase over one region of the world (normally the room
+// the player is in). Dynamic entities are registered every tick into the
+// cell holding the centre of their box, keyed by integer cell index, and
+// queries widen by the largest registered half-extent, so each entity is
+// stored once and never reported twice. Boxes outside the region fall into
+// the edge cells, which keeps queries correct anywhere.
+typedef struct spatialGrid *spatialGrid;
+
+// What an entry is, so one grid can serve several kinds of query
+#define SPATIAL_ENEMY      (1u << 0)
+#define SPATIAL_COMPUTER   (1u << 1)
+
+#define SPATIAL_CELL_SIZE  32.0f    // two tiles
+
+extern spatialGrid spatialCreate(float cellSize);
+extern void spatialFree(spatialGrid g);
+// Empty the grid and cover `bounds` for this tick.
+extern void spatialClear(spatialGrid g, Rectangle bounds);
+extern void spatialInsert(spatialGrid g, Rectangle box, unsigned kind, void *item);
+// `box` must be the one the item was inserted with.
+extern void spatialRemove(spatialGrid g, Rectangle box, void *item);
+
+// Fill `out` with up to `max` items of a kind in `kinds` whose box overlaps
+// the query; returns how many were written.
+extern int spatialQueryRect(spatialGrid g, Rectangle area, unsigned kinds, void **out, int max);
+extern int spatialQueryRadius(spatialGrid g, Vector2 centre, float radius, unsigned kinds, void **out, int max);
+
+#endif
@@ -9,9 +9,11 @@ struct Animation{
 };
 typedef struct Animation *Animation;
 
-extern Animation loadAnimation(char *path, int numberOfFrames);
-extern Texture2D *loadTexturesFromDirectory(char *path, int numberOfTexs);
 extern void loadDirectory();
 extern void closeDirectory();
+// Frame time the game simulates with. main sets it once per frame, from
+// GetFrameTime() or from a replay.
+extern float gameFrameTime(void);
+extern void gameSetFrameTime(float dt);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+// Converts a WAV file to 48kHz stereo QOA for src/music.c. Run by build.sh
+// before compiling:
+//
+//   cc tools/music.c -Iraylib/src -lm -o tools/music
+//   tools/music assets/music/bgm.wav assets/music/bgm.qoa
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DR_WAV_IMPLEMENTATION
+#include "external/dr_wav.h"
+#define QOA_IMPLEMENTATION
+#include "external/qoa.h"
+
+#include "../src/music.h"
+
+int main(int argc, char **argv){
+  if (argc != 3){
+    fprintf(stderr, "usage: %s <in.wav> <out.qoa>\n", argv[0]);
+    return 1;
+  }
+
+  unsigned int channels, rate;
+  drwav_uint64 frames;
+  drwav_int16 *in = drwav_open_file_and_read_pcm_frames_s16(argv[1], &channels, &rate, &frames, NULL);
+  if (in == NULL || frames == 0){
+    fprintf(stderr, "music: cannot read %s\n", argv[1]);
+    return 1;
+  }
+
+  // Linear resampling to the player's rate; mono is copied to both sides
+  // and channels past the second are dropped
+  unsigned int outFrames = (unsigned int)(frames * MUSIC_SAMPLE_RATE / rate);
+  short *out = malloc((size_t)outFrames * MUSIC_CHANNELS * sizeof(short));
+  if (out == NULL) return 1;
+  for (unsigned int i = 0; i < outFrames; i++){
+    double pos = (double)i * rate / MUSIC_SAMPLE_RATE;
+    drwav_uint64 a = (drwav_uint64)pos;
+    drwav_uint64 b = a + 1 < frames ? a + 1 : a;
+    double f = pos - (double)a;
+    for (int c = 0; c < MUSIC_CHANNELS; c++){
+      unsigned int src = c < (int)channels ? (unsigned int)c : 0;
+      double sample = in[a * channels + src] * (1.0 - f) + in[b * channels + src] * f;
+      out[i * MUSIC_CHANNELS + c] = (short)sample;
+    }
+  }
+  drwav_free(in, NULL);
+
+  qoa_desc desc = {0};
+  desc.channels = MUSIC_CHANNELS;
+  desc.samplerate = MUSIC_SAMPLE_RATE;
+  desc.samples = outFrames;
+  unsigned int bytes = qoa_write(argv[2], out, &desc);
+  free(out);
+  if (bytes == 0){
+    fprintf(stderr, "music: cannot write %s\n", argv[2]);
+    return 1;
+  }
+  printf("music: %s -> %s, %u bytes\n", argv[1], argv[2], bytes);
+  return 0;
+}
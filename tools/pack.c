@@ -0,0 +1,131 @@
+// Packs every PNG under an assets directory into one archive of raw RGBA8
+// pixels (see src/pack.h). Run by build.sh before compiling:
+//
+//   cc tools/pack.c -Iraylib/src -lm -o tools/pack
+//   tools/pack assets assets/textures.pak
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#include "external/stb_image.h"
+
+#include "../src/pack.h"
+
+typedef struct packFile{
+  char name[PACK_NAME_MAX];
+  unsigned char *pixels;
+  int width, height;
+} packFile;
+
+static packFile *files = NULL;
+static int fileCount = 0, fileCap = 0;
+
+static bool isPng(const char *name){
+  size_t len = strlen(name);
+  return len > 4 && strcmp(name + len - 4, ".png") == 0;
+}
+
+// rel is the path below root, "" for root itself
+static void collect(const char *root, const char *rel){
+  char dirPath[512];
+  snprintf(dirPath, sizeof(dirPath), "%s/%s", root, rel);
+  DIR *dir = opendir(dirPath);
+  if (dir == NULL) return;
+
+  struct dirent *ent;
+  while ((ent = readdir(dir)) != NULL){
+    if (ent->d_name[0] == '.') continue;
+    char relPath[512], fullPath[1024];
+    snprintf(relPath, sizeof(relPath), "%s%s%s", rel, rel[0] ? "/" : "", ent->d_name);
+    snprintf(fullPath, sizeof(fullPath), "%s/%s", root, relPath);
+
+    struct stat st;
+    if (stat(fullPath, &st) != 0) continue;
+    if (S_ISDIR(st.st_mode)){
+      collect(root, relPath);
+      continue;
+    }
+    if (!isPng(ent->d_name)) continue;
+    if (strlen(relPath) >= PACK_NAME_MAX){
+      fprintf(stderr, "pack: skipping %s, name too long\n", relPath);
+      continue;
+    }
+
+    if (fileCount == fileCap){
+      fileCap = fileCap ? fileCap * 2 : 64;
+      files = realloc(files, fileCap * sizeof(packFile));
+      assert(files != NULL);
+    }
+    packFile *f = &files[fileCount];
+    memset(f, 0, sizeof(*f));
+    strcpy(f->name, relPath);
+    int channels;
+    f->pixels = stbi_load(fullPath, &f->width, &f->height, &channels, 4);
+    if (f->pixels == NULL){
+      fprintf(stderr, "pack: cannot decode %s: %s\n", fullPath, stbi_failure_reason());
+      continue;
+    }
+    fileCount++;
+  }
+  closedir(dir);
+}
+
+static int byName(const void *a, const void *b){
+  return strncmp(((const packFile *)a)->name, ((const packFile *)b)->name, PACK_NAME_MAX);
+}
+
+static uint64_t alignUp(uint64_t v){
+  return (v + PACK_ALIGN - 1) & ~(uint64_t)(PACK_ALIGN - 1);
+}
+
+int main(int argc, char **argv){
+  if (argc != 3){
+    fprintf(stderr, "usage: %s <assets dir> <output.pak>\n", argv[0]);
+    return 1;
+  }
+  collect(argv[1], "");
+  // The game looks names up with a binary search
+  qsort(files, fileCount, sizeof(packFile), byName);
+
+  FILE *out = fopen(argv[2], "wb");
+  if (out == NULL){
+    fprintf(stderr, "pack: cannot write %s\n", argv[2]);
+    return 1;
+  }
+
+  packHeader header = {0};
+  memcpy(header.magic, PACK_MAGIC, 4);
+  header.version = PACK_VERSION;
+  header.count = fileCount;
+  fwrite(&header, sizeof(header), 1, out);
+
+  uint64_t offset = alignUp(sizeof(header) + (uint64_t)fileCount * sizeof(packEntry));
+  for (int i = 0; i < fileCount; i++){
+    packEntry e = {0};
+    memcpy(e.name, files[i].name, PACK_NAME_MAX);
+    e.width = files[i].width;
+    e.height = files[i].height;
+    e.offset = offset;
+    fwrite(&e, sizeof(e), 1, out);
+    offset = alignUp(offset + (uint64_t)e.width * e.height * 4);
+  }
+
+  static const unsigned char zeros[PACK_ALIGN] = {0};
+  for (int i = 0; i < fileCount; i++){
+    long pad = (long)(alignUp(ftell(out)) - ftell(out));
+    fwrite(zeros, 1, pad, out);
+    fwrite(files[i].pixels, 4, (size_t)files[i].width * files[i].height, out);
+    stbi_image_free(files[i].pixels);
+  }
+  long total = ftell(out);
+  fclose(out);
+  free(files);
+
+  printf("pack: %d images, %ld bytes -> %s\n", fileCount, total, argv[2]);
+  return 0;
+}